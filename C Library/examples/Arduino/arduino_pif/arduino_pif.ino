@@ -50,12 +50,19 @@ void displayDraw(void *p_Disp, pifINFO_t *p_Info, uint32_t pixel)
 }
 
 /* File I/O functions */
-uint16_t fSeekPos;  // Seeking only really is used when a indexed image is read, and no buffer is provided
+// Reading position within the flash array, kept per opened image instead of in a global
+typedef struct {
+  PGM_P imgArray;
+  uint16_t seekPos;  // Seeking only really is used when a indexed image is read, and no buffer is provided
+  uint8_t inUse;
+} flashFile_t;
+
+#define FLASH_FILES 2
+flashFile_t flashFiles[FLASH_FILES];
+
 void *openImage(const char* pc_filePath, int8_t *fileError)
 {
   PGM_P imgArray;
-  *fileError = 0;
-  fSeekPos = 0;
 
   // Check which of the two images has been requested, otherwise return an error  
   switch (pc_filePath[0])
@@ -70,24 +77,41 @@ void *openImage(const char* pc_filePath, int8_t *fileError)
       break;
     default:
       *fileError = 1;
+      return NULL;
   }
 
-  // Return the pointer to the image data array in the flash memory
-  return imgArray;
+  // Hand out a free reading position for the image data array in the flash memory
+  for (uint8_t i = 0; i < FLASH_FILES; i++)
+  {
+    if (!flashFiles[i].inUse)
+    {
+      flashFiles[i].inUse = 1;
+      flashFiles[i].imgArray = imgArray;
+      flashFiles[i].seekPos = 0;
+      *fileError = 0;
+      return &flashFiles[i];
+    }
+  }
+  *fileError = 1;
+  return NULL;
 }
 
 int8_t closeImage(void *p_file)
 {
-  // Nothing to do, since we're not dealing with actual file I/O
+  // Nothing to close since we're not dealing with actual file I/O, just release the reading position.
+  // Also called after a failed open, with no position handed out
+  if (p_file != NULL) ((flashFile_t *)p_file)->inUse = 0;
   return 0;
 }
 
 int8_t readImage(void *p_file, uint8_t *p_buffer, uint8_t size)
 {
+  flashFile_t *p_flashFile = (flashFile_t *)p_file;
+
   // Simply read the requested amount of bytes from the flash memory and increase the pointer
   for (uint8_t i = 0; i < size; i++)
   {
-    p_buffer[i] = pgm_read_byte((PGM_P)p_file + fSeekPos++);
+    p_buffer[i] = pgm_read_byte(p_flashFile->imgArray + p_flashFile->seekPos++);
   }
   return 0;
 }
@@ -95,7 +119,7 @@ int8_t readImage(void *p_file, uint8_t *p_buffer, uint8_t size)
 int8_t seekImage(void *p_file, uint32_t offset)
 {
   // Change flash-memory pointer
-  fSeekPos = offset;
+  ((flashFile_t *)p_file)->seekPos = offset;
   return 0;
 }
 
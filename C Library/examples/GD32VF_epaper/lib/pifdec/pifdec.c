@@ -282,7 +282,7 @@ pifRESULT pif_open(pifHANDLE_t *p_PIF, const char *pc_path)
 	if (_read32(p_PIF->pifFileHandler) != PIF_FORMAT_HEADER)
 	{
 		// Not the file we expected!
-		p_PIF->pifFileHandler->close(&(p_PIF->pifFileHandler->fileHandle));	
+		p_PIF->pifFileHandler->close(p_PIF->pifFileHandler->fileHandle);	
 		return PIF_RESULT_FORMATERR;
 	}
 	
@@ -348,7 +348,7 @@ pifRESULT pif_open(pifHANDLE_t *p_PIF, const char *pc_path)
 	
 	if (results)
 	{
-		if (p_PIF->pifFileHandler->close != NULL) p_PIF->pifFileHandler->close(&(p_PIF->pifFileHandler->fileHandle));
+		if (p_PIF->pifFileHandler->close != NULL) p_PIF->pifFileHandler->close(p_PIF->pifFileHandler->fileHandle);
 		return PIF_RESULT_FORMATERR;
 	}
 	return PIF_RESULT_OK;
@@ -543,7 +543,7 @@ pifRESULT pif_close(pifHANDLE_t *p_PIF)
 {
 	if (p_PIF->pifFileHandler->close != NULL)
 	{
-		if (p_PIF->pifFileHandler->close(&(p_PIF->pifFileHandler->fileHandle)))	return PIF_RESULT_IOERR;
+		if (p_PIF->pifFileHandler->close(p_PIF->pifFileHandler->fileHandle))	return PIF_RESULT_IOERR;
 	}
 	return PIF_RESULT_OK;
 }
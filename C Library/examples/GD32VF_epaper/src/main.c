@@ -65,7 +65,16 @@ void initMCU(void)
 	gpio_bit_set(GPIOB, DISPLAY_CS);
 }
 
-uint32_t iseekPos = 0;
+/* Reading position within the array, one per opened image instead of a global,
+ * so several handles can read the array at the same time */
+typedef struct {
+	uint32_t seekPos;
+	uint8_t inUse;
+}arrayFile_t;
+
+#define ARRAY_FILES		2
+arrayFile_t arrayFiles[ARRAY_FILES];
+
 int8_t prepStuff(void *p_Display, pifINFO_t* p_pifInfo)
 {
 	if ((p_pifInfo->imageType < PIF_TYPE_IND8) || (p_pifInfo->colTableSize != 7))
@@ -94,32 +103,47 @@ int8_t finishStuff(void *p_Display, pifINFO_t* p_pifInfo)
 
 void* openStuff(const char* pc_filePath, int8_t *fileError)
 {
-	// Since we are reading from flash, not much to prepare here
-	*fileError = 0;
-	iseekPos = 0;
+	// Since we are reading from flash, only a free reading position is required
+	for (uint8_t i = 0; i < ARRAY_FILES; i++)
+	{
+		if (!arrayFiles[i].inUse)
+		{
+			arrayFiles[i].inUse = 1;
+			arrayFiles[i].seekPos = 0;
+			*fileError = 0;
+			return &arrayFiles[i];
+		}
+	}
+	*fileError = 1;
 	return 0;
 }
 
 int8_t closeStuff(void *p_file)
 {
-	// Nothing to close
+	// Nothing to close, just release the reading position
+	for (uint8_t i = 0; i < ARRAY_FILES; i++)
+	{
+		if (p_file == &arrayFiles[i])	arrayFiles[i].inUse = 0;
+	}
 	return 0;
 }
 
 void readStuff(void *p_file, uint8_t *p_buffer, uint8_t size)
 {
+	arrayFile_t *p_arrayFile = (arrayFile_t *)p_file;
+	
 	// Simply read the amount of requested bytes from the byte array
 	for (uint8_t i = 0; i < size; i++)
 	{
 		// Read the next byte from the array and increase the seeking pointer
-		p_buffer[i] = redpaz[iseekPos++];
+		p_buffer[i] = redpaz[p_arrayFile->seekPos++];
 	}
 }
 
 int8_t seekStuff(void *p_file, uint32_t offset)
 {
 	// Change the seeking position
-	iseekPos = offset;
+	((arrayFile_t *)p_file)->seekPos = offset;
 	return 0;
 }
 
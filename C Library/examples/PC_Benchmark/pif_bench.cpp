@@ -0,0 +1,137 @@
+/*
+ * pif_bench.cpp
+ *
+ * Compares the C library (pif_display with function pointer callbacks) against
+ * the header-only C++ decoder (pif::Decoder with inlined source and sink).
+ * Both decode the same images from memory into a framebuffer, which are
+ * compared afterwards to make sure both produce the exact same output and
+ * return the same result.
+ *
+ * Build (from this folder):
+ *	gcc -O2 -pthread -c ../../pifdec.c -o pifdec.o
+ *	g++ -O2 -std=c++17 -pthread -I../.. pif_bench.cpp pifdec.o -o pif_bench
+ * Run:
+ *	./pif_bench ../../../test_images/Lenna/Lenna_RGB565.pif ../../../test_images/Lenna/Lenna_BW.pif
+ * Lenna_Indexed256_RGB565_16bpp_rle.pif stores its indices in 16 bit words, it checks the
+ * indexed images of more than 8 bits per pixel.
+ *
+ * Created: 17.10.2026
+ *  Author: gfcwfzkm
+ */
+
+#include "pifdec.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+/* Both decoders draw into a framebuffer with 32 bits per pixel, through the same sink */
+using Sink = pif::FramebufferSink<4>;
+
+/* Callbacks for the C library, forwarding to the sink */
+static int8_t c_prepare(void *p_Display, pifINFO_t *p_pifInfo)
+{
+	return static_cast<Sink *>(p_Display)->prepare(*p_pifInfo);
+}
+
+static void c_draw(void *p_Display, pifINFO_t *p_pifInfo, uint32_t pixel)
+{
+	static_cast<Sink *>(p_Display)->draw(*p_pifInfo, pixel);
+}
+
+static bool loadFile(const char *pc_path, std::vector<uint8_t> &data)
+{
+	FILE *p_file = std::fopen(pc_path, "rb");
+
+	if (p_file == nullptr)	return false;
+	std::fseek(p_file, 0, SEEK_END);
+	data.resize(std::ftell(p_file));
+	std::fseek(p_file, 0, SEEK_SET);
+	const bool ok = std::fread(data.data(), 1, data.size(), p_file) == data.size();
+	std::fclose(p_file);
+	return ok;
+}
+
+/* Runs the decoding function until at least 200ms passed, returns the time per image in microseconds */
+template <class Func>
+static double measure(Func decode)
+{
+	using clock = std::chrono::steady_clock;
+	uint32_t runs = 0;
+	const auto start = clock::now();
+	auto elapsed = clock::duration::zero();
+
+	do
+	{
+		decode();
+		runs++;
+		elapsed = clock::now() - start;
+	} while (elapsed < std::chrono::milliseconds(200));
+
+	return std::chrono::duration<double, std::micro>(elapsed).count() / runs;
+}
+
+int main(int argc, char **argv)
+{
+	int failed = 0;
+
+	if (argc < 2)
+	{
+		std::printf("Usage: %s image.pif [image.pif ...]\n", argv[0]);
+		return 1;
+	}
+
+	std::printf("%-40s %10s %10s %8s  %s\n", "Image", "C [us]", "C++ [us]", "Speedup", "Output");
+	for (int arg = 1; arg < argc; arg++)
+	{
+		std::vector<uint8_t> data;
+		if (!loadFile(argv[arg], data))
+		{
+			std::printf("%-40s could not be read\n", argv[arg]);
+			failed = 1;
+			continue;
+		}
+
+		// C library, reading from memory as well. pif_createPainter leaves the bypass flag alone, so start zeroed
+		pifPAINT_t pifPainter = {};
+		pifIO_t pifIO = {};
+		pifHANDLE_t pifHandle;
+		pif_createPIFHandle(&pifHandle, &pifIO, &pifPainter);
+
+		// C++ decoder
+		pif::MemorySource source(data.data(), data.size());
+		std::vector<uint32_t> cFrame, cppFrame;
+
+		if (pif_openMemory(&pifHandle, data.data(), data.size()) != PIF_RESULT_OK)
+		{
+			std::printf("%-40s is not a supported PIF image\n", argv[arg]);
+			failed = 1;
+			continue;
+		}
+		const pifINFO_t &pifInfo = pifHandle.pifInfo;
+		cFrame.assign((size_t)pifInfo.imageWidth * pifInfo.imageHeight, 0);
+		cppFrame.assign(cFrame.size(), 0);
+		Sink cSink(cFrame.data(), pifInfo.imageWidth * 4);
+		Sink cppSink(cppFrame.data(), pifInfo.imageWidth * 4);
+		pif::Decoder<pif::MemorySource, Sink> decoder(source, cppSink);
+		pif_createPainter(&pifPainter, c_prepare, c_draw, nullptr, &cSink, nullptr, 0);
+
+		if (decoder.open() != PIF_RESULT_OK)
+		{
+			std::printf("%-40s is not a supported PIF image\n", argv[arg]);
+			failed = 1;
+			continue;
+		}
+
+		pifRESULT cResult = PIF_RESULT_OK, cppResult = PIF_RESULT_OK;
+		const double cTime = measure([&] { cResult = pif_display(&pifHandle, 0, 0); });
+		const double cppTime = measure([&] { cppResult = decoder.display(0, 0); });
+		const bool same = (cResult == cppResult) && (std::memcmp(cFrame.data(), cppFrame.data(), cFrame.size() * sizeof(uint32_t)) == 0);
+
+		std::printf("%-40s %10.1f %10.1f %7.2fx  %s\n", argv[arg], cTime, cppTime, cTime / cppTime, same ? "identical" : "DIFFERENT");
+		if (!same)	failed = 1;
+	}
+
+	return failed;
+}
@@ -0,0 +1,293 @@
+/*
+ * pif_kernel_test.c
+ *
+ * Checks the SSSE3 row kernels of pif_decodeToBuffer against the scalar ones. The
+ * library is compiled into this test, so the CPU detection can be turned off in
+ * between: Every image is decoded into every framebuffer format with the kernels
+ * the CPU supports and again with the scalar ones, and both results have to match.
+ * Random rows of every indexed bit depth and widths up to a few chunks are expanded
+ * both ways as well, which covers the kernels even without indexed test images.
+ * Last, pif_convertRow has to give the same pixels as convertColor for every pair of
+ * image types and both conversion modes, with and without the SSE2 kernel. The time
+ * of pif_convertRow and of calling convertColor per pixel is printed for every
+ * conversion between the RGB formats.
+ *
+ * Build (from this folder, pifdec.c is included and not linked separately):
+ *	gcc -O2 -I../.. pif_kernel_test.c -o pif_kernel_test
+ * Run:
+ *	./pif_kernel_test image.pif [image.pif ...]
+ * for example with all images of the test_images folder.
+ *
+ * Created: 17.10.2026
+ *  Author: gfcwfzkm
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "pifdec.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static const pifImageType formats[] = {PIF_TYPE_RGB888, PIF_TYPE_RGB565, PIF_TYPE_RGB332};
+static const pifImageType allTypes[] = {PIF_TYPE_RGB888, PIF_TYPE_RGB565, PIF_TYPE_RGB332, PIF_TYPE_RGB16C,
+	PIF_TYPE_BW, PIF_TYPE_IND8, PIF_TYPE_IND16, PIF_TYPE_IND24};
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint8_t *loadFile(const char *pc_path, size_t *p_length)
+{
+	FILE *p_file = fopen(pc_path, "rb");
+	uint8_t *p8_data;
+	long length;
+
+	if (p_file == NULL)	return NULL;
+	fseek(p_file, 0, SEEK_END);
+	length = ftell(p_file);
+	fseek(p_file, 0, SEEK_SET);
+	p8_data = malloc(length);
+	if ((p8_data != NULL) && (fread(p8_data, 1, length, p_file) != (size_t)length))
+	{
+		free(p8_data);
+		p8_data = NULL;
+	}
+	fclose(p_file);
+	*p_length = length;
+	return p8_data;
+}
+
+/* Decode the image with the kernels given, returns the result of pif_decodeToBuffer */
+static pifRESULT decodeWith(pifHANDLE_t *p_pif, uint8_t simdKernels, uint8_t *p8_frame, size_t stride, pifImageType format)
+{
+#if defined(PIF_SSSE3_ROW_KERNELS)
+	const uint8_t detected = rowKernelsSSSE3;
+	pifRESULT result;
+
+	rowKernelsSSSE3 = simdKernels;
+	result = pif_decodeToBuffer(p_pif, p8_frame, stride, format);
+	rowKernelsSSSE3 = detected;
+	return result;
+#else
+	(void)simdKernels;
+	return pif_decodeToBuffer(p_pif, p8_frame, stride, format);
+#endif
+}
+
+/* Expand random rows of every bit depth and framebuffer size with and without the SSSE3 kernels */
+static uint32_t checkRows(uint8_t simdKernels)
+{
+	uint8_t src[512], simd[512 * 3], scalar[512 * 3];
+	uint32_t lut[256];
+	uint32_t failed = 0;
+	uint16_t pixels, i;
+	uint8_t bitsPerPixel, pixelBytes;
+
+	srand(1);
+	for (bitsPerPixel = 1; bitsPerPixel <= 8; bitsPerPixel++)
+	{
+		for (pixelBytes = 1; pixelBytes <= 3; pixelBytes++)
+		{
+			for (pixels = 1; pixels <= 3 * PIF_ROW_KERNEL_CHUNK + 8; pixels++)
+			{
+				for (i = 0; i < sizeof(src); i++)	src[i] = (uint8_t)rand();
+				for (i = 0; i < 256; i++)	lut[i] = (uint32_t)rand() & ((pixelBytes == 3) ? 0xFFFFFF : (pixelBytes == 2) ? 0xFFFF : 0xFF);
+				memset(simd, 0, sizeof(simd));
+				memset(scalar, 0, sizeof(scalar));
+				_expandRow(src, simd, pixels, bitsPerPixel, lut, pixelBytes, simdKernels);
+				_expandRow(src, scalar, pixels, bitsPerPixel, lut, pixelBytes, 0);
+				if (memcmp(simd, scalar, sizeof(simd)) != 0)
+				{
+					printf("Row of %u pixels with %u bits per pixel into %u bytes per pixel differs\n", pixels, bitsPerPixel, pixelBytes);
+					failed++;
+				}
+			}
+		}
+	}
+	return failed;
+}
+
+/* Convert colors of every pair of types with pif_convertRow and with convertColor. Sources of one or
+ * two bytes are checked with every color, RGB888 sources with a spread over all of them */
+static uint32_t checkConversions(void)
+{
+	uint32_t src[256], dst[256];
+	uint32_t failed = 0, color, pixel;
+	uint8_t source, target, mode;
+	pifRESULT result;
+
+	for (source = 0; source < sizeof(allTypes) / sizeof(allTypes[0]); source++)
+	{
+		for (target = 0; target < sizeof(allTypes) / sizeof(allTypes[0]); target++)
+		{
+			for (mode = 0; mode < 2; mode++)
+			{
+				const pifColorConversion convMode = mode ? PIF_CONV_FAST : PIF_CONV_ACCURATE;
+				uint32_t mismatches = 0;
+
+				for (color = 0; color < 0x10000; color += 256)
+				{
+					for (pixel = 0; pixel < 256; pixel++)
+					{
+						src[pixel] = ((color + pixel) * ((_formatBytes(allTypes[source]) == 3) ? 257 : 1)) & 0xFFFFFF;
+						if (_formatBytes(allTypes[source]) == 1)	src[pixel] &= 0xFF;
+					}
+					result = pif_convertRow(src, dst, 256, allTypes[source], allTypes[target], convMode);
+					if (result != PIF_RESULT_OK)	break;
+					for (pixel = 0; pixel < 256; pixel++)
+					{
+						if (dst[pixel] != convertColor(src[pixel], allTypes[source], allTypes[target], convMode))	mismatches++;
+					}
+				}
+				// Only BW and RGB16C are refused, these can't be converted by convertColor either
+				if ((result != PIF_RESULT_OK) && (_formatBytes(allTypes[source]) != 0) && (_formatBytes(allTypes[target]) != 0))	mismatches++;
+				if (mismatches)
+				{
+					printf("Conversion from type %u to type %u (mode %u) differs for %u colors\n", source, target, mode, mismatches);
+					failed++;
+				}
+			}
+		}
+	}
+	return failed;
+}
+
+/* Time pif_convertRow against calling convertColor for every pixel, on rows of a typical display width */
+static void timeConversions(void)
+{
+	static uint32_t src[320], dst[320];
+	const uint32_t rows = 20000;
+	uint8_t source, target, mode;
+	uint32_t row, pixel, sink = 0;
+	double start, rowTime, pixelTime, simdTime;
+
+	for (pixel = 0; pixel < 320; pixel++)	src[pixel] = (uint32_t)rand() & 0xFFFFFF;
+	printf("%-28s %12s %12s %12s\n", "Conversion [ns per pixel]", "convertColor", "convertRow", "with SSE2");
+	for (source = 0; source < 3; source++)
+	{
+		for (target = 0; target < 3; target++)
+		{
+			for (mode = 0; mode < 2; mode++)
+			{
+				const pifColorConversion convMode = mode ? PIF_CONV_FAST : PIF_CONV_ACCURATE;
+
+				if (source == target)	continue;
+				start = now();
+				for (row = 0; row < rows; row++)
+				{
+					for (pixel = 0; pixel < 320; pixel++)	dst[pixel] = convertColor(src[pixel] + row, formats[source], formats[target], convMode);
+					sink += dst[row % 320];
+				}
+				pixelTime = now() - start;
+
+#if defined(PIF_SSSE3_ROW_KERNELS)
+				const uint8_t detected = rowKernelsSSE2;
+
+				rowKernelsSSE2 = 0;
+#endif
+				start = now();
+				for (row = 0; row < rows; row++)
+				{
+					src[row % 320] += row;
+					pif_convertRow(src, dst, 320, formats[source], formats[target], convMode);
+					sink += dst[row % 320];
+				}
+				rowTime = now() - start;
+#if defined(PIF_SSSE3_ROW_KERNELS)
+				rowKernelsSSE2 = detected;
+#endif
+
+				start = now();
+				for (row = 0; row < rows; row++)
+				{
+					src[row % 320] += row;
+					pif_convertRow(src, dst, 320, formats[source], formats[target], convMode);
+					sink += dst[row % 320];
+				}
+				simdTime = now() - start;
+
+				printf("%u to %u bytes, %-8s        %12.2f %12.2f %12.2f\n", _formatBytes(formats[source]), _formatBytes(formats[target]),
+					mode ? "fast" : "accurate", pixelTime * 1e9 / (rows * 320.0), rowTime * 1e9 / (rows * 320.0), simdTime * 1e9 / (rows * 320.0));
+			}
+		}
+	}
+	if (sink == 1)	printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+	uint8_t simdKernels = 0;
+	uint32_t compared = 0, failed;
+	int arg;
+
+#if defined(PIF_SSSE3_ROW_KERNELS)
+	simdKernels = rowKernelsSSSE3;
+#endif
+	printf("Row kernels: %s\n", simdKernels ? "SSSE3 against scalar" : "scalar only, nothing to compare");
+
+	failed = checkRows(simdKernels);
+	failed += checkConversions();
+#if defined(PIF_SSSE3_ROW_KERNELS)
+	{
+		const uint8_t detected = rowKernelsSSE2;
+
+		rowKernelsSSE2 = 0;
+		failed += checkConversions();
+		rowKernelsSSE2 = detected;
+	}
+#endif
+	timeConversions();
+
+	for (arg = 1; arg < argc; arg++)
+	{
+		pifPAINT_t pifPainter = {0};
+		pifIO_t pifIO = {0};
+		pifHANDLE_t pifHandle;
+		uint8_t *p8_file, *p8_simd, *p8_scalar;
+		size_t fileLength, stride, frameSize;
+		uint8_t format;
+
+		p8_file = loadFile(argv[arg], &fileLength);
+		pif_createPIFHandle(&pifHandle, &pifIO, &pifPainter);
+		if ((p8_file == NULL) || (pif_openMemory(&pifHandle, p8_file, fileLength) != PIF_RESULT_OK))
+		{
+			printf("%s could not be opened\n", argv[arg]);
+			free(p8_file);
+			failed++;
+			continue;
+		}
+
+		for (format = 0; format < sizeof(formats) / sizeof(formats[0]); format++)
+		{
+			pifRESULT resultSimd, resultScalar;
+
+			stride = (size_t)pifHandle.pifInfo.imageWidth * _formatBytes(formats[format]);
+			frameSize = stride * pifHandle.pifInfo.imageHeight;
+			p8_simd = calloc(frameSize ? frameSize : 1, 1);
+			p8_scalar = calloc(frameSize ? frameSize : 1, 1);
+
+			resultSimd = decodeWith(&pifHandle, simdKernels, p8_simd, stride, formats[format]);
+			resultScalar = decodeWith(&pifHandle, 0, p8_scalar, stride, formats[format]);
+			if ((resultSimd != resultScalar) || (memcmp(p8_simd, p8_scalar, frameSize) != 0))
+			{
+				printf("%s into format %u differs\n", argv[arg], format);
+				failed++;
+			}
+			compared++;
+
+			free(p8_scalar);
+			free(p8_simd);
+		}
+		pif_close(&pifHandle);
+		free(p8_file);
+	}
+
+	printf("%u image decodes and the conversions of all type pairs compared: %s\n", compared, failed ? "FAILED" : "identical");
+	return failed != 0;
+}
@@ -0,0 +1,148 @@
+/*
+ * pif_parallel_bench.c
+ *
+ * Measures how pif_decodeParallel scales with the amount of threads. Every image
+ * is decoded from memory into a RGB888 framebuffer with 1 up to N threads, the
+ * output of every run is compared against the single threaded pif_decodeToBuffer.
+ * Large RLE images show the effect best, a row index stored in the file (or
+ * attached with -i) saves the pre-scan for the strip starts.
+ *
+ * Build (from this folder):
+ *	gcc -O2 -pthread -I../.. pif_parallel_bench.c ../../pifdec.c -o pif_parallel_bench
+ * Run:
+ *	./pif_parallel_bench [-t maxThreads] [-i everyNRows] image.pif [image.pif ...]
+ *
+ * Created: 17.10.2026
+ *  Author: gfcwfzkm
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "pifdec.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static uint8_t *loadFile(const char *pc_path, size_t *p_length)
+{
+	FILE *p_file = fopen(pc_path, "rb");
+	uint8_t *p8_data;
+	long length;
+
+	if (p_file == NULL)	return NULL;
+	fseek(p_file, 0, SEEK_END);
+	length = ftell(p_file);
+	fseek(p_file, 0, SEEK_SET);
+	p8_data = malloc(length);
+	if ((p8_data != NULL) && (fread(p8_data, 1, length, p_file) != (size_t)length))
+	{
+		free(p8_data);
+		p8_data = NULL;
+	}
+	fclose(p_file);
+	*p_length = length;
+	return p8_data;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static const char *compressionNames[] = {"uncompressed", "RLE", "extended RLE"};
+
+int main(int argc, char **argv)
+{
+	long maxThreads = sysconf(_SC_NPROCESSORS_ONLN);
+	long indexRows = 0;
+	int arg = 1, failed = 0;
+
+	for (; (arg < argc - 1) && (argv[arg][0] == '-'); arg += 2)
+	{
+		if (strcmp(argv[arg], "-t") == 0)	maxThreads = atol(argv[arg + 1]);
+		if (strcmp(argv[arg], "-i") == 0)	indexRows = atol(argv[arg + 1]);
+	}
+	if (arg >= argc)
+	{
+		printf("Usage: %s [-t maxThreads] [-i everyNRows] image.pif [image.pif ...]\n", argv[0]);
+		return 1;
+	}
+	if (maxThreads < 1)	maxThreads = 1;
+	if (maxThreads > PIF_PARALLEL_MAX_THREADS)	maxThreads = PIF_PARALLEL_MAX_THREADS;
+
+	for (; arg < argc; arg++)
+	{
+		pifPAINT_t pifPainter = {0};
+		pifIO_t pifIO = {0};
+		pifHANDLE_t pifHandle;
+		uint8_t *p8_file, *p8_ref, *p8_frame;
+		uint32_t *p32_index = NULL;
+		size_t fileLength, frameSize, stride;
+		double singleTime = 0;
+		long threads;
+
+		p8_file = loadFile(argv[arg], &fileLength);
+		pif_createPIFHandle(&pifHandle, &pifIO, &pifPainter);
+		if ((p8_file == NULL) || (pif_openMemory(&pifHandle, p8_file, fileLength) != PIF_RESULT_OK))
+		{
+			printf("%s could not be opened\n", argv[arg]);
+			free(p8_file);
+			failed = 1;
+			continue;
+		}
+
+		stride = (size_t)pifHandle.pifInfo.imageWidth * 3;
+		frameSize = stride * pifHandle.pifInfo.imageHeight;
+		p8_ref = malloc(frameSize);
+		p8_frame = malloc(frameSize);
+		pif_decodeToBuffer(&pifHandle, p8_ref, stride, PIF_TYPE_RGB888);
+
+		if (indexRows > 0)
+		{
+			p32_index = malloc(2 * sizeof(uint32_t) * ((pifHandle.pifInfo.imageHeight + indexRows - 1) / indexRows));
+			pif_buildRowIndex(&pifHandle, p32_index, (uint16_t)indexRows);
+		}
+
+		printf("%s: %ux%u, %s, row index: %s\n", argv[arg], pifHandle.pifInfo.imageWidth, pifHandle.pifInfo.imageHeight,
+			compressionNames[pifHandle.pifInfo.compression],
+			(p32_index != NULL) ? "attached" : pifHandle.pifInfo.fileRowIndexStep ? "in file" : "pre-scan");
+		printf("%8s %12s %10s %8s  %s\n", "Threads", "Time [ms]", "MPixel/s", "Speedup", "Output");
+
+		for (threads = 1; threads <= maxThreads; threads++)
+		{
+			uint32_t runs = 0;
+			double start = now(), elapsed;
+			int same;
+
+			// Run until at least 300ms passed
+			do
+			{
+				pif_decodeParallel(&pifHandle, p8_frame, stride, PIF_TYPE_RGB888, (uint8_t)threads);
+				runs++;
+				elapsed = now() - start;
+			} while (elapsed < 0.3);
+			elapsed /= runs;
+			if (threads == 1)	singleTime = elapsed;
+
+			same = memcmp(p8_ref, p8_frame, frameSize) == 0;
+			printf("%8ld %12.3f %10.1f %7.2fx  %s\n", threads, elapsed * 1e3,
+				(double)pifHandle.pifInfo.imageWidth * pifHandle.pifInfo.imageHeight / elapsed * 1e-6,
+				singleTime / elapsed, same ? "identical" : "DIFFERENT");
+			if (!same)	failed = 1;
+		}
+		printf("\n");
+
+		free(p32_index);
+		free(p8_frame);
+		free(p8_ref);
+		free(p8_file);
+	}
+
+	return failed;
+}
@@ -0,0 +1,301 @@
+/*
+ * pif_rle_bench.c
+ *
+ * Compares images stored with the basic RLE against the same images with extended
+ * RLE, which stores runs and literal blocks of up to 8191 words in a single
+ * instruction. Prints the file size, the amount of RLE instructions in the image
+ * data and the time pif_display takes to decode the image from memory, once drawing
+ * every pixel and once with pif_setRunFilling, where every run turns into a single
+ * fill call. Both decodes are compared against each other.
+ * Extended RLE images are also checked with the first instruction replaced by a count
+ * beyond PIF_FORMAT_RLE_EXT_MAX, which pif_display, pif_feed and pif_buildRowIndex have
+ * to reject with PIF_RESULT_FORMATERR.
+ * Images with a row index (RIDX block) stored in the file, as written by pif.py with
+ * rowIndexRows, get a few regions decoded with pif_displayRegion, which starts at the
+ * indexed row above the region. Every region is compared against the same part of the
+ * full image.
+ *
+ * Build (from this folder):
+ *	gcc -O2 -I../.. pif_rle_bench.c ../../pifdec.c -o pif_rle_bench
+ * Run:
+ *	./pif_rle_bench image_rle.pif image_rle_ext.pif [image.pif ...]
+ * The images can be made with pif.py, using RLE_COMPRESSION and RLE_EXT_COMPRESSION.
+ * test_pif.py saves images of both kinds to Python Library/testing, the *_ridx.pif ones
+ * with a row index.
+ *
+ * Created: 17.10.2026
+ *  Author: gfcwfzkm
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "pifdec.h"
+#include "pifdec_format.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static uint32_t *p32_frame;
+
+static void drawPixel(void *p_display, pifINFO_t *p_info, uint32_t pixel)
+{
+	(void)p_display;
+	p32_frame[(size_t)p_info->currentY * p_info->imageWidth + p_info->currentX] = pixel;
+}
+
+/* The run may continue on the next rows, which follow in the framebuffer */
+static void fillRun(void *p_display, pifINFO_t *p_info, uint32_t pixel, uint16_t count)
+{
+	uint32_t *p32_pixel = &p32_frame[(size_t)p_info->currentY * p_info->imageWidth + p_info->currentX];
+
+	(void)p_display;
+	while (count--)	*p32_pixel++ = pixel;
+}
+
+static uint8_t *loadFile(const char *pc_path, size_t *p_length)
+{
+	FILE *p_file = fopen(pc_path, "rb");
+	uint8_t *p8_data;
+	long length;
+
+	if (p_file == NULL)	return NULL;
+	fseek(p_file, 0, SEEK_END);
+	length = ftell(p_file);
+	fseek(p_file, 0, SEEK_SET);
+	p8_data = malloc(length);
+	if ((p8_data != NULL) && (fread(p8_data, 1, length, p_file) != (size_t)length))
+	{
+		free(p8_data);
+		p8_data = NULL;
+	}
+	fclose(p_file);
+	*p_length = length;
+	return p8_data;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Walk through the image data and count the RLE instructions */
+static uint32_t countInstructions(const uint8_t *p8_data, const pifINFO_t *p_info)
+{
+	const uint8_t wordBytes = (p_info->bitsPerPixel < 8) ? 1 : p_info->bitsPerPixel >> 3;
+	uint32_t pos = 0, instructions = 0;
+	int16_t rleInstr;
+
+	if (p_info->compression == PIF_COMPRESSION_NONE)	return 0;
+	while (pos < p_info->imageSize)
+	{
+		rleInstr = (int8_t)p8_data[pos++];
+		if ((rleInstr == 0) && (p_info->compression == PIF_COMPRESSION_RLE_EXT) && (pos + 2 <= p_info->imageSize))
+		{
+			rleInstr = (int16_t)(p8_data[pos] | (p8_data[pos + 1] << 8));
+			pos += 2;
+		}
+		pos += (rleInstr > 0) ? wordBytes : (uint32_t)(-rleInstr) * wordBytes;
+		instructions++;
+	}
+	return instructions;
+}
+
+/* Replace the first instruction of the image opened last by an extended count one word too long
+ * and check that the decoding functions reject it. Returns the amount of functions that accepted it */
+static int checkInvalidCount(pifHANDLE_t *p_pif, const uint8_t *p8_file, size_t fileLength)
+{
+	const uint16_t invalidCount = PIF_FORMAT_RLE_EXT_MAX + 1;
+	const uint32_t offset = p_pif->pifInfo.imageOffset;
+	// A row index stored in the file is copied instead of scanning the image data
+	const uint16_t indexRows = (p_pif->pifInfo.fileRowIndexStep == 16) ? 8 : 16;
+	uint8_t *p8_bad = malloc(fileLength);
+	uint32_t *p32_index;
+	pifFEED_t feed;
+	int accepted = 0;
+
+	if (p8_bad == NULL)	return 1;
+	memcpy(p8_bad, p8_file, fileLength);
+	p8_bad[offset] = 0;
+	p8_bad[offset + 1] = invalidCount & 0xFF;
+	p8_bad[offset + 2] = invalidCount >> 8;
+
+	pif_openMemory(p_pif, p8_bad, fileLength);
+	if (pif_display(p_pif, 0, 0) != PIF_RESULT_FORMATERR)	accepted++;
+	p32_index = calloc(2 * ((p_pif->pifInfo.imageHeight + indexRows - 1) / indexRows), sizeof(uint32_t));
+	if (pif_buildRowIndex(p_pif, p32_index, indexRows) != PIF_RESULT_FORMATERR)	accepted++;
+	// Indexed images can't be fed without a color table buffer, which the painter doesn't have
+	if (p_pif->pifInfo.imageType <= PIF_TYPE_BW)
+	{
+		pif_feedStart(&feed, p_pif->pifDecoder, 0, 0);
+		if (pif_feed(&feed, p8_bad, fileLength) != PIF_RESULT_FORMATERR)	accepted++;
+	}
+	pif_close(p_pif);
+
+	free(p32_index);
+	free(p8_bad);
+	return accepted;
+}
+
+/* Decode a region of the image opened last and compare it with the reference frame:
+ * Inside the region the pixels of the full image, nothing drawn outside of it */
+static int checkRegion(pifHANDLE_t *p_pif, const uint8_t *p8_file, size_t fileLength, const uint32_t *p32_ref,
+	uint16_t srcX, uint16_t srcY, uint16_t regWidth, uint16_t regHeight)
+{
+	const uint16_t width = p_pif->pifInfo.imageWidth, height = p_pif->pifInfo.imageHeight;
+	uint16_t x, y;
+	int same = 1;
+
+	memset(p32_frame, 0, (size_t)width * height * sizeof(uint32_t));
+	pif_openMemory(p_pif, p8_file, fileLength);
+	if (pif_displayRegion(p_pif, srcX, srcY, regWidth, regHeight, srcX, srcY) != PIF_RESULT_OK)	same = 0;
+	pif_close(p_pif);
+	for (y = 0; (y < height) && same; y++)
+	{
+		for (x = 0; (x < width) && same; x++)
+		{
+			const int inside = (x >= srcX) && (x - srcX < regWidth) && (y >= srcY) && (y - srcY < regHeight);
+
+			same = p32_frame[(size_t)y * width + x] == (inside ? p32_ref[(size_t)y * width + x] : 0);
+		}
+	}
+	return same;
+}
+
+/* Decode regions of the image opened last through the row index of the file and compare
+ * them with the reference frame. Returns the amount of regions that differ */
+static int checkRowIndexRegions(pifHANDLE_t *p_pif, const uint8_t *p8_file, size_t fileLength, const uint32_t *p32_ref)
+{
+	const uint16_t width = p_pif->pifInfo.imageWidth, height = p_pif->pifInfo.imageHeight;
+	const uint16_t step = p_pif->pifInfo.fileRowIndexStep;
+	// Starting on, just below and just above an indexed row, the last row and a single column
+	const uint16_t regions[][4] = {
+		{0, step, width, step},
+		{width / 4, step + 1, width / 2, height / 3},
+		{width / 3, 2 * step - 1, width / 3, 2},
+		{0, height - 1, width, 1},
+		{width - 1, height / 2, 1, height / 2}
+	};
+	uint32_t row;
+	uint16_t region;
+	int differ = 0;
+
+	for (region = 0; region < sizeof(regions) / sizeof(regions[0]); region++)
+	{
+		// Regions beyond the bottom of small images are left out
+		if (regions[region][1] >= height)	continue;
+		if (!checkRegion(p_pif, p8_file, fileLength, p32_ref, regions[region][0], regions[region][1], regions[region][2], regions[region][3]))	differ++;
+	}
+	// A row out of every indexed block of rows, so every entry of the index gets used
+	for (row = 0; row < height; row += step)
+	{
+		const uint16_t y = (row + (row / step) % step < height) ? row + (row / step) % step : row;
+
+		if (!checkRegion(p_pif, p8_file, fileLength, p32_ref, 0, y, width, 1))	differ++;
+	}
+	return differ;
+}
+
+/* Decodes the image until at least 300ms passed, returns the time per image in milliseconds */
+static double measure(pifHANDLE_t *p_pif, const uint8_t *p8_file, size_t fileLength)
+{
+	uint32_t runs = 0;
+	double start = now(), elapsed;
+
+	do
+	{
+		pif_openMemory(p_pif, p8_file, fileLength);
+		pif_display(p_pif, 0, 0);
+		pif_close(p_pif);
+		runs++;
+		elapsed = now() - start;
+	} while (elapsed < 0.3);
+	return elapsed / runs * 1e3;
+}
+
+int main(int argc, char **argv)
+{
+	const char *compressionNames[] = {"none", "RLE", "ext. RLE"};
+	int arg, failed = 0;
+
+	if (argc < 2)
+	{
+		printf("Usage: %s image.pif [image.pif ...]\n", argv[0]);
+		return 1;
+	}
+
+	printf("%-40s %-8s %10s %12s %12s %12s  %s\n", "Image", "Format", "Size [B]", "Instructions",
+		"Pixels [ms]", "Fill [ms]", "Output");
+	for (arg = 1; arg < argc; arg++)
+	{
+		pifPAINT_t pifPainter;
+		pifIO_t pifIO = {0};
+		pifHANDLE_t pifHandle;
+		uint32_t *p32_ref;
+		uint8_t *p8_file;
+		size_t fileLength, pixels;
+		uint32_t instructions;
+		double pixelTime, fillTime;
+		int same;
+
+		memset(&pifPainter, 0, sizeof(pifPainter));
+		pif_createPainter(&pifPainter, NULL, drawPixel, NULL, NULL, NULL, 0);
+		pif_createPIFHandle(&pifHandle, &pifIO, &pifPainter);
+		p8_file = loadFile(argv[arg], &fileLength);
+		if ((p8_file == NULL) || (pif_openMemory(&pifHandle, p8_file, fileLength) != PIF_RESULT_OK))
+		{
+			printf("%s could not be opened\n", argv[arg]);
+			free(p8_file);
+			failed = 1;
+			continue;
+		}
+		pixels = (size_t)pifHandle.pifInfo.imageWidth * pifHandle.pifInfo.imageHeight;
+		instructions = countInstructions(&p8_file[pifHandle.pifInfo.imageOffset], &(pifHandle.pifInfo));
+		pif_close(&pifHandle);
+
+		p32_ref = calloc(pixels ? pixels : 1, sizeof(uint32_t));
+		p32_frame = calloc(pixels ? pixels : 1, sizeof(uint32_t));
+
+		// Every pixel drawn on its own, the output is the reference for the run filling
+		pixelTime = measure(&pifHandle, p8_file, fileLength);
+		memcpy(p32_ref, p32_frame, pixels * sizeof(uint32_t));
+
+		pif_setRunFilling(&pifPainter, fillRun);
+		memset(p32_frame, 0, pixels * sizeof(uint32_t));
+		fillTime = measure(&pifHandle, p8_file, fileLength);
+
+		same = memcmp(p32_ref, p32_frame, pixels * sizeof(uint32_t)) == 0;
+		printf("%-40s %-8s %10zu %12u %12.3f %12.3f  %s\n", argv[arg], compressionNames[pifHandle.pifInfo.compression],
+			fileLength, instructions, pixelTime, fillTime, same ? "identical" : "DIFFERENT");
+		if (!same)	failed = 1;
+
+		// Regions have to start at the right place within the RLE data through the stored row index
+		if ((pifHandle.pifInfo.compression != PIF_COMPRESSION_NONE) && (pifHandle.pifInfo.fileRowIndexStep != 0))
+		{
+			const int differ = checkRowIndexRegions(&pifHandle, p8_file, fileLength, p32_ref);
+
+			printf("%-40s row index every %u rows, regions %s\n", argv[arg], pifHandle.pifInfo.fileRowIndexStep,
+				differ ? "DIFFERENT" : "identical");
+			if (differ)	failed = 1;
+		}
+
+		// The invalid instruction needs three bytes of image data
+		if ((pifHandle.pifInfo.compression == PIF_COMPRESSION_RLE_EXT) && (pifHandle.pifInfo.imageSize >= 3))
+		{
+			const int accepted = checkInvalidCount(&pifHandle, p8_file, fileLength);
+
+			printf("%-40s invalid extended count %s\n", argv[arg], accepted ? "ACCEPTED" : "rejected");
+			if (accepted)	failed = 1;
+		}
+
+		free(p32_frame);
+		free(p32_ref);
+		free(p8_file);
+	}
+
+	return failed;
+}
@@ -0,0 +1,313 @@
+/*
+ * pif_scan.c
+ *
+ * Lists all PIF images below the given folders without opening them through the
+ * decoder. Only the first PIF_HEADER_SIZE bytes of every file are read, by several
+ * threads that take the files in batches, and parsed with pif_probe. Prints one line
+ * per image (-q only prints the summary) and the time taken by the folder walk, the
+ * header reads and by pif_probe alone, which shows that the parsing is negligible
+ * compared to opening the files.
+ *
+ * With -o, a catalog of all images found is written as well. It holds the header of
+ * every image together with the hash of its path relative to the scanned folder, sorted
+ * by the hash. A device keeps it in flash and gets the size of an image with
+ * pif_catalogFind instead of opening the image file.
+ *
+ * Build (from this folder):
+ *	gcc -O2 -pthread -I../.. pif_scan.c ../../pifdec.c -o pif_scan
+ * Run:
+ *	./pif_scan [-t threads] [-a] [-q] [-o catalog.bin] folder [folder ...]
+ * -a checks every file instead of only the ones ending in .pif
+ *
+ * Created: 17.10.2026
+ *  Author: gfcwfzkm
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include "pifdec.h"
+
+#include <fcntl.h>
+#include <ftw.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_THREADS		64
+#define BATCH_SIZE		64			// Files a thread takes at once from the list
+
+#define CATALOG_MAGIC	"PIFC"
+#define CATALOG_VERSION	1
+#define CATALOG_ENTRY	28			// Path hash followed by the image header without its magic
+
+typedef struct {
+	char *pc_path;
+	const char *pc_name;			// Path relative to the scanned folder, as stored in the catalog
+	uint32_t hash;
+	uint8_t header[PIF_HEADER_SIZE];
+	pifRESULT result;				// PIF_RESULT_IOERR if the header couldn't be read
+	pifINFO_t info;
+}entry_t;
+
+static entry_t *p_entries;
+static size_t entryCount, entrySize;
+static size_t nextEntry;
+static pthread_mutex_t entryLock = PTHREAD_MUTEX_INITIALIZER;
+static int allFiles;
+static size_t rootLength;
+
+static const char *typeNames[] = {"RGB888", "RGB565", "RGB332", "RGB16C", "BW", "IND8", "IND16", "IND24"};
+static const char *compressionNames[] = {"-", "RLE", "RLEX"};
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* nftw callback, collects the paths of the files to check */
+static int addFile(const char *pc_path, const struct stat *p_stat, int type, struct FTW *p_ftw)
+{
+	size_t length = strlen(pc_path);
+
+	(void)p_stat;
+	(void)p_ftw;
+	if (type != FTW_F)	return 0;
+	if (!allFiles && ((length < 4) || (strcasecmp(&pc_path[length - 4], ".pif") != 0)))	return 0;
+
+	if (entryCount == entrySize)
+	{
+		entry_t *p_new;
+
+		entrySize = entrySize ? entrySize * 2 : 1024;
+		p_new = realloc(p_entries, entrySize * sizeof(entry_t));
+		if (p_new == NULL)	return 1;
+		p_entries = p_new;
+	}
+	p_entries[entryCount].pc_path = strdup(pc_path);
+	p_entries[entryCount].pc_name = p_entries[entryCount].pc_path;
+	if (p_entries[entryCount].pc_path != NULL)
+	{
+		// Files in a folder are named by the path below it, a file given directly by its name
+		if (length > rootLength)	p_entries[entryCount].pc_name += rootLength;
+		else if (strrchr(pc_path, '/') != NULL)	p_entries[entryCount].pc_name += strrchr(pc_path, '/') + 1 - pc_path;
+		while (*p_entries[entryCount].pc_name == '/')	p_entries[entryCount].pc_name++;
+	}
+	memset(p_entries[entryCount].header, 0, PIF_HEADER_SIZE);
+	p_entries[entryCount].result = PIF_RESULT_IOERR;
+	entryCount++;
+	return 0;
+}
+
+/* Read only the header of the file, a file too short for it is no PIF image either */
+static pifRESULT readHeader(entry_t *p_entry)
+{
+	int fd;
+	ssize_t length;
+
+	if (p_entry->pc_path == NULL)	return PIF_RESULT_IOERR;
+	fd = open(p_entry->pc_path, O_RDONLY);
+	if (fd < 0)	return PIF_RESULT_IOERR;
+	length = pread(fd, p_entry->header, PIF_HEADER_SIZE, 0);
+	close(fd);
+
+	if (length < 0)	return PIF_RESULT_IOERR;
+	if (length < PIF_HEADER_SIZE)	return PIF_RESULT_FORMATERR;
+	return pif_probe(p_entry->header, &(p_entry->info));
+}
+
+/* Takes batches of files from the list until all of them are done */
+static void *scanThread(void *p_arg)
+{
+	size_t first, last;
+
+	(void)p_arg;
+	for (;;)
+	{
+		pthread_mutex_lock(&entryLock);
+		first = nextEntry;
+		last = (entryCount - first > BATCH_SIZE) ? first + BATCH_SIZE : entryCount;
+		nextEntry = last;
+		pthread_mutex_unlock(&entryLock);
+		if (first == last)	return NULL;
+
+		for (; first < last; first++)
+		{
+			p_entries[first].result = readHeader(&p_entries[first]);
+		}
+	}
+}
+
+static void put16(uint8_t *p8_data, uint16_t value)
+{
+	p8_data[0] = (uint8_t)value;
+	p8_data[1] = (uint8_t)(value >> 8);
+}
+
+static void put32(uint8_t *p8_data, uint32_t value)
+{
+	put16(p8_data, (uint16_t)value);
+	put16(&p8_data[2], (uint16_t)(value >> 16));
+}
+
+static int compareHash(const void *p_a, const void *p_b)
+{
+	uint32_t a = (*(const entry_t * const *)p_a)->hash;
+	uint32_t b = (*(const entry_t * const *)p_b)->hash;
+
+	return (a > b) - (a < b);
+}
+
+/* Write all images found into a catalog sorted by the hash of their path */
+static int writeCatalog(const char *pc_catalog)
+{
+	entry_t **pp_sorted = malloc((entryCount ? entryCount : 1) * sizeof(entry_t *));
+	uint8_t data8[CATALOG_ENTRY];
+	size_t images = 0, i;
+	FILE *p_file;
+	int failed = 0;
+
+	if (pp_sorted == NULL)	return 1;
+	for (i = 0; i < entryCount; i++)
+	{
+		if (p_entries[i].result != PIF_RESULT_OK)	continue;
+		p_entries[i].hash = pif_catalogHash(p_entries[i].pc_name);
+		pp_sorted[images++] = &p_entries[i];
+	}
+	qsort(pp_sorted, images, sizeof(entry_t *), compareHash);
+
+	// The device only compares hashes, two paths with the same hash can't be told apart
+	for (i = 1; i < images; i++)
+	{
+		if (pp_sorted[i]->hash == pp_sorted[i - 1]->hash)
+		{
+			printf("%s and %s have the same hash (or name), rename one of them\n", pp_sorted[i - 1]->pc_path, pp_sorted[i]->pc_path);
+			failed = 1;
+		}
+	}
+
+	p_file = failed ? NULL : fopen(pc_catalog, "wb");
+	if (p_file == NULL)
+	{
+		failed = 1;
+	}
+	else
+	{
+		memcpy(data8, CATALOG_MAGIC, 4);
+		put16(&data8[4], CATALOG_VERSION);
+		put16(&data8[6], CATALOG_ENTRY);
+		put32(&data8[8], (uint32_t)images);
+		put32(&data8[12], 0);
+		fwrite(data8, 1, 16, p_file);
+		for (i = 0; i < images; i++)
+		{
+			put32(data8, pp_sorted[i]->hash);
+			memcpy(&data8[4], &(pp_sorted[i]->header[4]), CATALOG_ENTRY - 4);
+			fwrite(data8, 1, CATALOG_ENTRY, p_file);
+		}
+		failed = (fclose(p_file) != 0);
+	}
+
+	if (failed)	printf("%s could not be written\n", pc_catalog);
+	else		printf("Catalog of %zu images written to %s (%zu bytes)\n", images, pc_catalog, 16 + images * CATALOG_ENTRY);
+	free(pp_sorted);
+	return failed;
+}
+
+int main(int argc, char **argv)
+{
+	pthread_t threads[MAX_THREADS];
+	long threadCount = 16;
+	size_t images = 0, others = 0, failed = 0, i;
+	double start, walkTime, readTime, probeTime = 0;
+	uint32_t probes = 0;
+	const char *pc_catalog = NULL;
+	int quiet = 0, arg = 1;
+
+	for (; (arg < argc) && (argv[arg][0] == '-'); arg++)
+	{
+		if ((strcmp(argv[arg], "-t") == 0) && (arg < argc - 1))	threadCount = atol(argv[++arg]);
+		else if (strcmp(argv[arg], "-a") == 0)	allFiles = 1;
+		else if (strcmp(argv[arg], "-q") == 0)	quiet = 1;
+		else if ((strcmp(argv[arg], "-o") == 0) && (arg < argc - 1))	pc_catalog = argv[++arg];
+	}
+	if (arg >= argc)
+	{
+		printf("Usage: %s [-t threads] [-a] [-q] [-o catalog.bin] folder [folder ...]\n", argv[0]);
+		return 1;
+	}
+	if (threadCount < 1)	threadCount = 1;
+	if (threadCount > MAX_THREADS)	threadCount = MAX_THREADS;
+
+	start = now();
+	for (; arg < argc; arg++)
+	{
+		rootLength = strlen(argv[arg]);
+		if (nftw(argv[arg], addFile, 64, FTW_PHYS) != 0)	printf("%s could not be read completely\n", argv[arg]);
+	}
+	walkTime = now() - start;
+
+	// The threads spend most of their time waiting for open and read, more of them than cores keep the disk busy
+	start = now();
+	for (i = 0; i < (size_t)threadCount; i++)	pthread_create(&threads[i], NULL, scanThread, NULL);
+	for (i = 0; i < (size_t)threadCount; i++)	pthread_join(threads[i], NULL);
+	readTime = now() - start;
+
+	for (i = 0; i < entryCount; i++)
+	{
+		const entry_t *p_entry = &p_entries[i];
+
+		if (p_entry->result == PIF_RESULT_OK)
+		{
+			images++;
+			if (!quiet)
+			{
+				printf("%-7s %5ux%-5u %4s %10u  %s\n", typeNames[p_entry->info.imageType], p_entry->info.imageWidth,
+					p_entry->info.imageHeight, compressionNames[p_entry->info.compression],
+					p_entry->info.fileSize, p_entry->pc_path);
+			}
+		}
+		else if (p_entry->result == PIF_RESULT_FORMATERR)
+		{
+			others++;
+			if (!quiet && !allFiles)	printf("%-30s  %s\n", "not a supported PIF image", p_entry->pc_path);
+		}
+		else
+		{
+			failed++;
+			if (!quiet)	printf("%-30s  %s\n", "could not be read", p_entry->pc_path);
+		}
+	}
+
+	// Parse the headers already in memory again, to see how much of the scan was spent on parsing
+	if (entryCount)
+	{
+		pifINFO_t info;
+
+		start = now();
+		do
+		{
+			for (i = 0; i < entryCount; i++)	pif_probe(p_entries[i].header, &info);
+			probes += entryCount;
+			probeTime = now() - start;
+		} while (probeTime < 0.1);
+	}
+
+	printf("\n%zu files: %zu images, %zu other files, %zu unreadable\n", entryCount, images, others, failed);
+	printf("Folder walk %.1f ms, header reads with %ld threads %.1f ms (%.0f files/s)\n", walkTime * 1e3,
+		threadCount, readTime * 1e3, readTime > 0 ? entryCount / readTime : 0.0);
+	printf("pif_probe %.1f ns per header, %.3f ms for all files\n", probes ? probeTime / probes * 1e9 : 0.0,
+		probes ? probeTime / probes * entryCount * 1e3 : 0.0);
+
+	if ((pc_catalog != NULL) && writeCatalog(pc_catalog))	failed++;
+
+	for (i = 0; i < entryCount; i++)	free(p_entries[i].pc_path);
+	free(p_entries);
+	return failed != 0;
+}
@@ -0,0 +1,254 @@
+/*
+ * pif_thread_test.c
+ *
+ * Decodes all given images from several threads at the same time and checks every
+ * result against a single threaded decode. All threads share one pifIO_t and one
+ * pifPAINT_t, only the pifHANDLE_t, its read-ahead buffer and the framebuffer
+ * belong to a thread. The draw functions find the framebuffer of the calling thread
+ * through the pifINFO_t pointer, which is part of the handle. Every thread walks the
+ * images in its own order, reading them from the file and from memory in turns.
+ *
+ * Build (from this folder):
+ *	gcc -O2 -pthread -I../.. pif_thread_test.c ../../pifdec.c -o pif_thread_test
+ * Run:
+ *	./pif_thread_test [-t threads] [-r rounds] image.pif [image.pif ...]
+ * for example with all images of the test_images folder and 8 threads. Images with a row
+ * index (RIDX block, written by pif.py with rowIndexRows, e.g. the *_ridx.pif files of
+ * test_pif.py) are decoded like any other image, the index is only used for regions.
+ *
+ * Created: 17.10.2026
+ *  Author: gfcwfzkm
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "pifdec.h"
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_THREADS		64
+
+typedef struct {
+	const char *pc_path;
+	uint8_t *p8_file;			// Whole file, for pif_openMemory
+	size_t fileLength;
+	uint32_t *p32_ref;			// Pixels of the single threaded decode
+	size_t pixels;
+}image_t;
+
+typedef struct {
+	pifHANDLE_t pifHandle;		// Has to stay in here, the draw functions get to the worker through it
+	uint8_t readBuf[512];
+	uint32_t *p32_frame;
+	uint16_t threadNo;
+	uint32_t decoded;
+	uint32_t failed;
+}worker_t;
+
+static pifIO_t pifIO;
+static pifPAINT_t pifPainter;
+static image_t *p_images;
+static int imageCount;
+static int rounds = 4;
+
+/* The pifINFO_t pointer handed to the draw functions points into the handle of the worker */
+static worker_t *getWorker(pifINFO_t *p_info)
+{
+	return (worker_t *)((char *)p_info - offsetof(worker_t, pifHandle) - offsetof(pifHANDLE_t, pifInfo));
+}
+
+static void drawPixel(void *p_display, pifINFO_t *p_info, uint32_t pixel)
+{
+	(void)p_display;
+	getWorker(p_info)->p32_frame[(size_t)p_info->currentY * p_info->imageWidth + p_info->currentX] = pixel;
+}
+
+static void fillRun(void *p_display, pifINFO_t *p_info, uint32_t pixel, uint16_t count)
+{
+	uint32_t *p32_pixel = &(getWorker(p_info)->p32_frame[(size_t)p_info->currentY * p_info->imageWidth + p_info->currentX]);
+
+	(void)p_display;
+	while (count--)	*p32_pixel++ = pixel;
+}
+
+static void *fileOpen(const char *pc_path, int8_t *p_error)
+{
+	FILE *p_file = fopen(pc_path, "rb");
+
+	*p_error = (p_file == NULL);
+	return p_file;
+}
+
+static int8_t fileClose(void *p_file)
+{
+	return fclose((FILE *)p_file) != 0;
+}
+
+static void fileRead(void *p_file, uint8_t *p8_buf, size_t length)
+{
+	if (fread(p8_buf, 1, length, (FILE *)p_file) != length)	memset(p8_buf, 0, length);
+}
+
+static int8_t fileSeek(void *p_file, uint32_t u32_filePos)
+{
+	return fseek((FILE *)p_file, u32_filePos, SEEK_SET) != 0;
+}
+
+static uint8_t *loadFile(const char *pc_path, size_t *p_length)
+{
+	FILE *p_file = fopen(pc_path, "rb");
+	uint8_t *p8_data;
+	long length;
+
+	if (p_file == NULL)	return NULL;
+	fseek(p_file, 0, SEEK_END);
+	length = ftell(p_file);
+	fseek(p_file, 0, SEEK_SET);
+	p8_data = malloc(length);
+	if ((p8_data != NULL) && (fread(p8_data, 1, length, p_file) != (size_t)length))
+	{
+		free(p8_data);
+		p8_data = NULL;
+	}
+	fclose(p_file);
+	*p_length = length;
+	return p8_data;
+}
+
+/* Decode an image into the framebuffer of the worker, either from the file or from memory */
+static pifRESULT decodeImage(worker_t *p_w, const image_t *p_img, int fromMemory)
+{
+	pifRESULT result;
+
+	memset(p_w->p32_frame, 0, p_img->pixels * sizeof(uint32_t));
+	if (fromMemory)
+	{
+		result = pif_openMemory(&(p_w->pifHandle), p_img->p8_file, p_img->fileLength);
+		if (result == PIF_RESULT_OK)	result = pif_display(&(p_w->pifHandle), 0, 0);
+		pif_close(&(p_w->pifHandle));
+		return result;
+	}
+	return pif_OpenAndDisplay(&(p_w->pifHandle), p_img->pc_path, 0, 0);
+}
+
+static void *workerThread(void *p_arg)
+{
+	worker_t *p_w = (worker_t *)p_arg;
+	int round, i;
+
+	for (round = 0; round < rounds; round++)
+	{
+		for (i = 0; i < imageCount; i++)
+		{
+			// Every thread and round starts at a different image, every other thread walks backwards
+			int index = (i + p_w->threadNo + round * 7) % imageCount;
+			const image_t *p_img;
+
+			if (p_w->threadNo & 1)	index = imageCount - 1 - index;
+			p_img = &(p_images[index]);
+			if (p_img->p32_ref == NULL)	continue;
+
+			if ((decodeImage(p_w, p_img, (round + p_w->threadNo) & 1) != PIF_RESULT_OK) ||
+				(memcmp(p_w->p32_frame, p_img->p32_ref, p_img->pixels * sizeof(uint32_t)) != 0))
+			{
+				printf("Thread %u, round %d: %s differs\n", p_w->threadNo, round, p_img->pc_path);
+				p_w->failed++;
+			}
+			p_w->decoded++;
+		}
+	}
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	static worker_t workers[MAX_THREADS];
+	pthread_t threads[MAX_THREADS];
+	long threadCount = 4;
+	size_t maxPixels = 0;
+	uint32_t decoded = 0, failed = 0;
+	int arg = 1, i;
+
+	for (; (arg < argc - 1) && (argv[arg][0] == '-'); arg += 2)
+	{
+		if (strcmp(argv[arg], "-t") == 0)	threadCount = atol(argv[arg + 1]);
+		if (strcmp(argv[arg], "-r") == 0)	rounds = atoi(argv[arg + 1]);
+	}
+	if (arg >= argc)
+	{
+		printf("Usage: %s [-t threads] [-r rounds] image.pif [image.pif ...]\n", argv[0]);
+		return 1;
+	}
+	if (threadCount < 1)	threadCount = 1;
+	if (threadCount > MAX_THREADS)	threadCount = MAX_THREADS;
+
+	// One I/O structure and one painter without any arrays for all threads
+	pif_createIOBlock(&pifIO, fileOpen, fileClose, fileRead, fileSeek);
+	pif_createPainter(&pifPainter, NULL, drawPixel, NULL, NULL, NULL, 0);
+	pif_setRunFilling(&pifPainter, fillRun);
+
+	// Single threaded reference decodes
+	imageCount = argc - arg;
+	p_images = calloc(imageCount, sizeof(image_t));
+	pif_createPIFHandle(&(workers[0].pifHandle), &pifIO, &pifPainter);
+	for (i = 0; i < imageCount; i++)
+	{
+		image_t *p_img = &(p_images[i]);
+
+		p_img->pc_path = argv[arg + i];
+		p_img->p8_file = loadFile(p_img->pc_path, &(p_img->fileLength));
+		if ((p_img->p8_file == NULL) ||
+			(pif_openMemory(&(workers[0].pifHandle), p_img->p8_file, p_img->fileLength) != PIF_RESULT_OK))
+		{
+			printf("%s could not be opened\n", p_img->pc_path);
+			failed++;
+			continue;
+		}
+		p_img->pixels = (size_t)workers[0].pifHandle.pifInfo.imageWidth * workers[0].pifHandle.pifInfo.imageHeight;
+		pif_close(&(workers[0].pifHandle));
+		if (p_img->pixels > maxPixels)	maxPixels = p_img->pixels;
+
+		p_img->p32_ref = malloc(p_img->pixels * sizeof(uint32_t));
+		workers[0].p32_frame = p_img->p32_ref;
+		if (decodeImage(&(workers[0]), p_img, 0) != PIF_RESULT_OK)
+		{
+			printf("%s could not be decoded\n", p_img->pc_path);
+			free(p_img->p32_ref);
+			p_img->p32_ref = NULL;
+			failed++;
+		}
+	}
+
+	for (i = 0; i < threadCount; i++)
+	{
+		pif_createPIFHandle(&(workers[i].pifHandle), &pifIO, &pifPainter);
+		pif_setReadBuffer(&(workers[i].pifHandle), workers[i].readBuf, sizeof(workers[i].readBuf));
+		workers[i].p32_frame = malloc((maxPixels ? maxPixels : 1) * sizeof(uint32_t));
+		workers[i].threadNo = (uint16_t)i;
+		workers[i].decoded = 0;
+		workers[i].failed = 0;
+		pthread_create(&threads[i], NULL, workerThread, &workers[i]);
+	}
+	for (i = 0; i < threadCount; i++)
+	{
+		pthread_join(threads[i], NULL);
+		decoded += workers[i].decoded;
+		failed += workers[i].failed;
+		free(workers[i].p32_frame);
+	}
+
+	printf("%ld threads, %d images, %u decodes: %s\n", threadCount, imageCount, decoded,
+		failed ? "FAILED" : "all identical to the single threaded decode");
+
+	for (i = 0; i < imageCount; i++)
+	{
+		free(p_images[i].p32_ref);
+		free(p_images[i].p8_file);
+	}
+	free(p_images);
+	return failed != 0;
+}
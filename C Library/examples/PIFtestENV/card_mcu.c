@@ -328,23 +328,44 @@ static void fm_flushRx(void)
 	} while ((uart_getc(&(mcuBoard->uartConsole)) >> 8) != UART_NO_DATA);
 }
 
-FIL imageFile;
+// Every opened image gets its own file object, so several PIF handles can be in use at once
+#define IMAGE_FILES		2
+FIL imageFiles[IMAGE_FILES];
+uint8_t imageFileUsed[IMAGE_FILES];
+
 void *ImageOpen(const char *path, int8_t *result)
 {
-	FRESULT res;
-	res = f_open(&imageFile, path, FA_READ);
+	FRESULT res = FR_TOO_MANY_OPEN_FILES;
+	uint8_t i;
+	
+	for (i = 0; i < IMAGE_FILES; i++)
+	{
+		if (!imageFileUsed[i])
+		{
+			res = f_open(&imageFiles[i], path, FA_READ);
+			break;
+		}
+	}
 	gs_log_f((res == FR_OK) ? GLOG_INFO : GLOG_ERROR, "[PIF] Opening Image '%s'... %s! Code %"PRIu8, path, (res == FR_OK) ? "OK" : "FAILED", res);
 	if (res != FR_OK)
 	{
 		*result |= 1;
+		return NULL;
 	}
 	
-	return &imageFile;
+	imageFileUsed[i] = 1;
+	return &imageFiles[i];
 }
 
 int8_t ImageClose(void *pHandle)
 {
 	FRESULT res = f_close(pHandle);
+	uint8_t i;
+	
+	for (i = 0; i < IMAGE_FILES; i++)
+	{
+		if (pHandle == &imageFiles[i])	imageFileUsed[i] = 0;
+	}
 	gs_log_f(GLOG_INFO, "[PIF] Closing file... %s! Code %"PRIu8, (res == FR_OK) ? "OK" : "FAILED", res);
 	if (res != FR_OK)
 	{
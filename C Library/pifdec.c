@@ -11,558 +11,2939 @@
  */ 
 
 #include "pifdec.h"
+#include "pifdec_format.h"
+#include <string.h>
 
-#if defined(AVR) && !defined(__GNUG__)
-	#include <avr/pgmspace.h>
-	#define _PMEMX	__memx
-	#define _PRGM
-#elif defined(AVR) && defined(__GNUG__)
-	#include <avr/pgmspace.h>
-	#define ARDUINO_IN_USE
-	#define _PMEMX 
-	#define _PRGM	PROGMEM
+// Forces the decoding loop to be inlined into every format specialization,
+// while the color table lookup stays out of it to keep the loop small
+#if defined(__GNUC__)
+	#define _PIF_ALWAYS_INLINE	inline __attribute__((always_inline))
+	#define _PIF_NOINLINE		__attribute__((noinline))
 #else
-	#define _PMEMX
-	#define _PRGM
-#endif
-
-
-// CGA / 16 Color palette generated with the following formula:
-// red	 = 255 * (2/3 * (colorNumber & 4)/4 + 1/3 * (colorNumber & 8)/8 )
-// green = 255 * (2/3 * (colorNumber & 2)/2 + 1/3 * (colorNumber & 8)/8 )
-// blue	 = 255 * (2/3 * (colorNumber & 1)/1 + 1/3 * (colorNumber & 8)/8 )
-#if defined(PIF_RGB16C_RGB888)
-const _PMEMX uint8_t color_table_16C[48] _PRGM = {
-	0, 0, 0,		// black
-	0, 0, 170,		// blue
-	0, 170, 0,		// green
-	0, 170, 170,	// cyan
-	170, 0, 0,		// red
-	170, 0, 170,	// magenta
-	170, 170, 0,	// dark yellow
-	170, 170, 170,	// light gray
-	85, 85, 85,		// dark gray
-	85, 85, 255,	// light blue
-	85, 255, 85,	// light green
-	85, 255, 255,	// light cyan
-	255, 85, 85,	// light red
-	255, 85, 255,	// light magenta
-	255, 255, 85,	// yellow
-	255, 255, 255	// white
-};
-#elif defined(PIF_RGB16C_RGB565)
-const _PMEMX uint8_t color_table_16C[32] _PRGM = {
-	0x00, 0x00,	// black
-	0x00, 0x15,	// blue
-	0x05, 0x40,	// green
-	0x05, 0x55,	// cyan
-	0xA8, 0x0,	// red
-	0xA8, 0x15,	// magenta
-	0xAD, 0x40,	// dark yellow
-	0xAD, 0x55,	// light gray
-	0x52, 0xAA,	// dark gray
-	0x52, 0xBF,	// light blue
-	0x57, 0xEA,	// light green
-	0x57, 0xFF,	// light cyan
-	0xFA, 0xAA,	// light red
-	0xFA, 0xBF,	// light magenta
-	0xFF, 0xEA,	// yellow
-	0xFF, 0xFF	// white
-};
-#elif defined(PIF_RGB16C_RGB332)
-const _PMEMX uint8_t color_table_16C[16] _PRGM = {
-	0x00,	// black
-	0x02,	// blue
-	0x14,	// green
-	0x16,	// cyan
-	0xA0,	// red
-	0xA2,	// magenta
-	0xB4,	// dark yellow
-	0xB6,	// light gray
-	0x49,	// dark gray
-	0x4B,	// light blue
-	0x5D,	// light green
-	0x5F,	// light cyan
-	0xF5,	// light red
-	0xEB,	// light magenta
-	0xFD,	// yellow
-	0xFF	// white
-};
+	#define _PIF_ALWAYS_INLINE	inline
+	#define _PIF_NOINLINE
+#endif
+
+// GCC only vectorizes loops from -O3 onwards (before version 12), the row conversion asks for it
+// at any level. Gives NEON code on ARM, where no hand written kernels exist
+#if defined(__GNUC__) && !defined(__clang__)
+	#define _PIF_VECTORIZE		__attribute__((optimize("tree-vectorize")))
 #else
-	#error "You need to configure which color-format you want to use for the RGB16C image mode!"
-#endif
-
-#define PIF_MONOCHROME_BLACK	0x000000
-#define PIF_MONOCHROME_WHITE	0xFFFFFF
-
-#define PIF_FORMAT_HEADER	0x00464950	// 'PIF\0' as String in LittleEndian
-#define PIF_FORMAT_RGB888	0x433C
-#define PIF_FORMAT_RGB565	0xE5C5
-#define PIF_FORMAT_RGB332	0x1E53
-#define PIF_FORMAT_RGB16C	0xB895
-#define PIF_FORMAT_BW		0x7DAA
-#define PIF_FORMAT_IND24	0x4952
-#define PIF_FORMAT_IND16	0x4947
-#define PIF_FORMAT_IND8		0x4942
-#define PIF_FORMAT_COMPR	0x7DDE
-#define PIF_FORMAT_COLORTABLE_OFFSET	0x1C
-#define PIF_MASK_INDEXED_COLOR_SIZE		0x03
-#define PIF_MASK_INDEXED_MODE_IN_USE	0x04
+	#define _PIF_VECTORIZE
+#endif
+
+// Pixels expanded at once by the row kernels of pif_decodeToBuffer, a multiple of 8
+#define PIF_ROW_KERNEL_CHUNK	64
+
+// SSSE3 palette lookup and SSE2 color conversion for x86 hosts, selected at runtime
+#if defined(PIF_SIMD_ROW_KERNELS) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#include <tmmintrin.h>
+	#define PIF_SSSE3_ROW_KERNELS
+#endif
+
+// Worker threads of pif_decodeParallel on hosts with POSIX threads
+#if defined(PIF_PARALLEL_DECODING) && (defined(__unix__) || defined(__APPLE__)) && !defined(AVR)
+	#include <pthread.h>
+	#define PIF_PTHREADS
+#endif
+
+/* Destination of pif_decodeToBuffer */
+typedef struct {
+	uint8_t *p8_row;			// Start of the current row in the framebuffer
+	size_t stride;				// Distance between two rows in bytes
+	uint8_t pixelBytes;			// Bytes per pixel in the framebuffer
+	pifImageType srcFormat;		// Format of RGB image data, to convert it if it doesn't match
+	pifImageType dstFormat;		// Format of the framebuffer
+	const uint32_t *p32_lut;	// Colors of indexed images already in the framebuffer format, NULL for RGB images
+	uint16_t endRow;			// Decoding stops in front of this row
+	uint8_t simdKernels;		// Non-zero if the row kernels may use SSSE3
+}pifBUFFER_t;
+
+/* Read a byte of an image in memory, either RAM or (on AVR) the program memory */
+static inline uint8_t _memRead(pifSTREAM_t *p_io, uint32_t u32_pos)
+{
+#if defined(AVR)
+	if (p_io->memFlashAddr)
+	{
+	#if defined(RAMPZ)
+		return pgm_read_byte_far(p_io->memFlashAddr + u32_pos);
+	#else
+		return pgm_read_byte((uint16_t)(p_io->memFlashAddr + u32_pos));
+	#endif
+	}
+#endif
+	return p_io->memData[u32_pos];
+}
+
+/* Read any amount of bytes through the block read function, or
+ * split it up into 255 byte reads if only readByte is available */
+static void _ioRead(pifSTREAM_t *p_io, uint8_t *p8_data, size_t length)
+{
+	uint8_t chunkSize;
+	
+	if (p_io->fileIO->readBlock != NULL)
+	{
+		p_io->fileIO->readBlock(p_io->fileHandle, p8_data, length);
+	}
+	else
+	{
+		for (; length; length -= chunkSize, p8_data += chunkSize)
+		{
+			chunkSize = (length > 0xFF) ? 0xFF : (uint8_t)length;
+			p_io->fileIO->readByte(p_io->fileHandle, p8_data, chunkSize);
+		}
+	}
+}
+
+/* Top up the read-ahead buffer with the next block of the file, capped at ioLimit.
+ * Unread bytes are moved to the start of the buffer first.
+ * Returns the amount of unread bytes now available in the buffer */
+static uint16_t _fillReadBuf(pifSTREAM_t *p_io)
+{
+	uint16_t unread = p_io->readBufFill - p_io->readBufPos;
+	uint16_t blockSize = p_io->readBufLen - unread;
+	
+	if (p_io->ioPos >= p_io->ioLimit)
+	{
+		blockSize = 0;
+	}
+	else if ((p_io->ioLimit - p_io->ioPos) < blockSize)
+	{
+		blockSize = p_io->ioLimit - p_io->ioPos;
+	}
+	
+	if (unread && p_io->readBufPos)
+	{
+		memmove(p_io->readBuf, &(p_io->readBuf[p_io->readBufPos]), unread);
+	}
+	if (blockSize)
+	{
+		_ioRead(p_io, &(p_io->readBuf[unread]), blockSize);
+	}
+	p_io->readBufPos = 0;
+	p_io->readBufFill = unread + blockSize;
+	p_io->ioPos += blockSize;
+	
+	return p_io->readBufFill;
+}
+
+/* Get a pointer to the next rowBytes of the file inside the read-ahead buffer.
+ * Returns NULL if the buffer is missing, too small or the data is exhausted */
+static const uint8_t *_readRow(pifSTREAM_t *p_io, uint32_t rowBytes)
+{
+	const uint8_t *p8_row;
+	
+	if (p_io->memLen)
+	{
+		// Images in RAM don't need any buffering at all. A position past the end comes from seeking
+		if ((p_io->memData == NULL) || (p_io->ioPos > p_io->memLen) || ((p_io->memLen - p_io->ioPos) < rowBytes))	return NULL;
+		p8_row = &(p_io->memData[p_io->ioPos]);
+		p_io->ioPos += rowBytes;
+		return p8_row;
+	}
+	
+	if ((p_io->readBuf == NULL) || (p_io->readBufLen < rowBytes))	return NULL;
+	
+	if ((uint16_t)(p_io->readBufFill - p_io->readBufPos) < rowBytes)
+	{
+		if (_fillReadBuf(p_io) < rowBytes)	return NULL;
+	}
+	p8_row = &(p_io->readBuf[p_io->readBufPos]);
+	p_io->readBufPos += rowBytes;
+	
+	return p8_row;
+}
+
+/* Read a few bytes from the file, either through the read-ahead buffer or directly */
+static void _readBytes(pifSTREAM_t *p_io, uint8_t *p8_data, uint8_t length)
+{
+	if (p_io->memLen)
+	{
+		// Reading past the end of the image in memory returns zeros
+		for (; length; length--)
+		{
+			*p8_data++ = (p_io->ioPos < p_io->memLen) ? _memRead(p_io, p_io->ioPos++) : 0;
+		}
+	}
+	else if (p_io->readBuf != NULL)
+	{
+		while (length)
+		{
+			if (p_io->readBufPos >= p_io->readBufFill)
+			{
+				if (_fillReadBuf(p_io) == 0)	break;
+			}
+			*p8_data++ = p_io->readBuf[p_io->readBufPos++];
+			length--;
+		}
+	}
+	
+	// Unbuffered read, or reading beyond the read-ahead limit
+	if (length)
+	{
+		_ioRead(p_io, p8_data, length);
+		p_io->ioPos += length;
+	}
+}
+
+/* Move the reading position. Seeks within the read-ahead buffer or to the
+ * current position are resolved without calling the seek callback */
+static void _seek(pifSTREAM_t *p_io, uint32_t u32_filePos)
+{
+	uint32_t bufStart = p_io->ioPos - p_io->readBufFill;
+	
+	if (p_io->memLen)
+	{
+		p_io->ioPos = u32_filePos;
+	}
+	else if ((u32_filePos >= bufStart) && (u32_filePos <= p_io->ioPos))
+	{
+		p_io->readBufPos = u32_filePos - bufStart;
+	}
+	else
+	{
+		p_io->fileIO->seekPos(p_io->fileHandle, u32_filePos);
+		p_io->ioPos = u32_filePos;
+		p_io->readBufPos = 0;
+		p_io->readBufFill = 0;
+	}
+}
+
+/* File position of the next byte to be read */
+static inline uint32_t _tell(pifSTREAM_t *p_io)
+{
+	if (p_io->memLen)	return p_io->ioPos;
+	return p_io->ioPos - (p_io->readBufFill - p_io->readBufPos);
+}
+
+/* Read bytes at any file position without losing the current reading position
+ * or the content of the read-ahead buffer */
+static void _readAt(pifSTREAM_t *p_io, uint32_t u32_filePos, uint8_t *p8_data, uint8_t length)
+{
+	uint32_t bufStart = p_io->ioPos - p_io->readBufFill;
+	
+	if (p_io->memLen)
+	{
+		while (length--)
+		{
+			*p8_data++ = (u32_filePos < p_io->memLen) ? _memRead(p_io, u32_filePos) : 0;
+			u32_filePos++;
+		}
+	}
+	else if ((u32_filePos >= bufStart) && ((u32_filePos + length) <= p_io->ioPos))
+	{
+		// Already buffered, no I/O required
+		while (length--)	*p8_data++ = p_io->readBuf[u32_filePos++ - bufStart];
+	}
+	else
+	{
+		p_io->fileIO->seekPos(p_io->fileHandle, u32_filePos);
+		_ioRead(p_io, p8_data, length);
+		p_io->fileIO->seekPos(p_io->fileHandle, p_io->ioPos);
+	}
+}
 
 /* Read data at various sizes, making sure the right endian is used */
-uint8_t _read8(pifIO_t *p_io)
+uint8_t _read8(pifSTREAM_t *p_io)
 {
 	uint8_t data8;
 	
-	p_io->readByte(p_io->fileHandle, &data8, 1);
+	// Fast path: byte is already in the read-ahead buffer or in memory
+	if (p_io->readBufPos < p_io->readBufFill)
+	{
+		return p_io->readBuf[p_io->readBufPos++];
+	}
+	if (p_io->memLen)
+	{
+		return (p_io->ioPos < p_io->memLen) ? _memRead(p_io, p_io->ioPos++) : 0;
+	}
+	_readBytes(p_io, &data8, 1);
 	
 	return data8;
 }
 
-uint16_t _read16(pifIO_t *p_io)
+uint16_t _read16(pifSTREAM_t *p_io)
 {
 	uint8_t data8[2];
 	
-	p_io->readByte(p_io->fileHandle, data8, 2);
+	_readBytes(p_io, data8, 2);
 	
 	return (uint16_t)data8[1] << 8 | data8[0];
 }
 
 // __uint24 is supported only on some plattforms but not on all of them, so treat it as u32
-uint32_t _read24(pifIO_t *p_io)
+uint32_t _read24(pifSTREAM_t *p_io)
 {
 	uint8_t data8[3];
 	
-	p_io->readByte(p_io->fileHandle, data8, 3);
+	_readBytes(p_io, data8, 3);
 	
 	return (uint32_t)data8[2] << 16 | (uint32_t)data8[1] << 8 | data8[0];
 }
 
-uint32_t _read32(pifIO_t *p_io)
+uint32_t _read32(pifSTREAM_t *p_io)
 {
 	uint8_t data8[4];
 	
-	p_io->readByte(p_io->fileHandle, data8, 4);
+	_readBytes(p_io, data8, 4);
 	
 	return (uint32_t)data8[3] << 24 | (uint32_t)data8[2] << 16 | (uint32_t)data8[1] << 8 | data8[0];
 }
 
-/* Read the static color table for BW / RGB16C */
-static inline uint32_t _getRGB16C(uint8_t color)
-{
-#if defined(ARDUINO_IN_USE)
-	#warning "Arduino static indexed colors not fully tested - be aware!"
-	#if defined(PIF_RGB16C_RGB888)
-		return ((uint32_t)pgm_read_dword(&(color_table_16C[color * 3])) << 16) | ((uint32_t)pgm_read_dword(&(color_table_16C[color * 3 + 1))] << 8) | (pgm_read_dword(&(color_table_16C[color * 3 + 2])));
-	#elif defined(PIF_RGB16C_RGB565)
-		return ((uint32_t)pgm_read_dword(&(color_table_16C[color * 2])) << 8) | ((uint32_t)pgm_read_dword(&(color_table_16C[color * 2 + 1])));
-	#elif defined(PIF_RGB16C_RGB332)
-		return ((uint32_t)pgm_read_dword(&(color_table_16C[color])));
-	#else
-		#error "You need to configure which color-format you want to use for the RGB16C image mode!"
-	#endif
-#else
-	#if defined(PIF_RGB16C_RGB888)
-		return ((uint32_t)color_table_16C[color * 3] << 16) | ((uint32_t)color_table_16C[color * 3 + 1] << 8) | (color_table_16C[color * 3 + 2]);
-	#elif defined(PIF_RGB16C_RGB565)
-		return ((uint32_t)color_table_16C[color * 2] << 8) | ((uint32_t)color_table_16C[color * 2 + 1]);
-	#elif defined(PIF_RGB16C_RGB332)
-		return ((uint32_t)color_table_16C[color]);
-	#else
-		#error "You need to configure which color-format you want to use for the RGB16C image mode!"
-	#endif
-#endif
-}
-
-/* Read the indexed color either from the buffer or from the file */
-static inline uint32_t _getIndexedColor(uint8_t color, pifHANDLE_t *p_pif, uint8_t *seekUsed)
+/* Read the indexed color either from the buffer, the color cache or from the file */
+static _PIF_NOINLINE uint32_t _getIndexedColor(uint8_t color, pifHANDLE_t *p_pif)
 {
 	uint8_t mult = p_pif->pifInfo.imageType & PIF_MASK_INDEXED_COLOR_SIZE;
+	uint8_t data8[3] = {0, 0, 0};
 	uint32_t pixelColor;
+#if PIF_COLOR_CACHE_SIZE > 0
+	pifCOLORCACHE_t * const p_cache = &(p_pif->colCache);
+#endif
 	
-	// If any colors have been loaded, use the buffered color table, otherwise seek back and forth (slow operation!)
+	// If any colors have been loaded, use the buffered color table, otherwise read it from the file (slow operation!)
 	if (((color+1) * mult) <= p_pif->pifDecoder->colTableBufLen)
 	{
 		pixelColor = p_pif->pifDecoder->colTableBuf[mult * color];
 		if (mult > 1)	pixelColor |= (uint32_t)p_pif->pifDecoder->colTableBuf[mult * color + 1] << 8;
 		if (mult > 2)	pixelColor |= (uint32_t)p_pif->pifDecoder->colTableBuf[mult * color + 2] << 16;
+#if PIF_COLOR_CACHE_SIZE > 0
+		p_cache->bufHits++;
+#endif
+		return pixelColor;
 	}
-	else
+	
+#if PIF_COLOR_CACHE_SIZE > 0
+	for (uint8_t entry = 0; entry < p_cache->fill; entry++)
 	{
-		*seekUsed = 1;
-		p_pif->pifFileHandler->seekPos(p_pif->pifFileHandler->fileHandle, PIF_FORMAT_COLORTABLE_OFFSET + (mult * color));
-		if (p_pif->pifInfo.imageType == PIF_TYPE_IND8)
-		{
-			pixelColor = _read8(p_pif->pifFileHandler);
-		}
-		else if (p_pif->pifInfo.imageType == PIF_TYPE_IND16)
-		{
-			pixelColor = _read16(p_pif->pifFileHandler);
-		}
-		else
+		if (p_cache->index[entry] == color)
 		{
-			pixelColor = _read24(p_pif->pifFileHandler);
+			p_cache->cacheHits++;
+			return p_cache->color[entry];
 		}
 	}
+#endif
+	
+	_readAt(&(p_pif->pifStream), PIF_FORMAT_COLORTABLE_OFFSET + (mult * color), data8, mult);
+	pixelColor = (uint32_t)data8[2] << 16 | (uint32_t)data8[1] << 8 | data8[0];
+	
+#if PIF_COLOR_CACHE_SIZE > 0
+	// Replace the oldest entry once the cache is full
+	p_cache->cacheMisses++;
+	p_cache->index[p_cache->next] = color;
+	p_cache->color[p_cache->next] = pixelColor;
+	if (p_cache->fill < PIF_COLOR_CACHE_SIZE)	p_cache->fill++;
+	if (++p_cache->next >= PIF_COLOR_CACHE_SIZE)	p_cache->next = 0;
+#endif
 	
 	return pixelColor;
 }
 
-/* Process the indexed image by looking up the color table */
-uint8_t _processIndexed(pifHANDLE_t *p_pif, uint8_t pixelGroup)
+/* Hand a collected span over to the display. Called with currentX pointing
+ * behind the last pixel of the span, spans never cross the end of a row */
+static void _flushSpan(pifHANDLE_t *p_pif)
 {
-	uint8_t seek_used = 0;
-	uint8_t pixelCounter = 0;
-	uint8_t const bitsPerPixel = (p_pif->pifInfo.bitsPerPixel == 3) ? 4 : p_pif->pifInfo.bitsPerPixel;
-	uint8_t const pixelLimit = 8 / bitsPerPixel;
-	uint8_t const pixelMask = (1 << p_pif->pifInfo.bitsPerPixel) - 1;
+	const uint16_t nextX = p_pif->pifInfo.currentX;
 	
-	// Process the bits, that are packed within a byte and look up it's color
-	for (;pixelCounter < pixelLimit; pixelCounter++)
+	p_pif->pifInfo.currentX = nextX - p_pif->spanFill;
+	p_pif->pifDecoder->drawSpan(p_pif->pifDecoder->displayHandle, &(p_pif->pifInfo), p_pif->pifDecoder->spanBuf, p_pif->spanFill);
+	p_pif->pifInfo.currentX = nextX;
+	p_pif->spanFill = 0;
+}
+
+/* Send a single pixel to the display, or collect it into the span buffer, and move on to the next position */
+static inline void _drawPixel(pifHANDLE_t *p_pif, uint32_t pixel)
+{
+	// Pixels outside of the drawn region are skipped, so are the padding bits after the last pixel of the image
+	if (((uint16_t)(p_pif->pifInfo.currentY - p_pif->pifInfo.regionY) < p_pif->pifInfo.regionHeight) &&
+		((uint16_t)(p_pif->pifInfo.currentX - p_pif->pifInfo.regionX) < p_pif->pifInfo.regionWidth))
 	{
-		// If the color table is to be bypassed, send the raw value straight to the drawing function,
-		// otherwise look it up according to the image format
-		if (p_pif->pifDecoder->bypassColTable == PIF_INDEXED_NORMAL_OPERATION)
+		if (p_pif->pifDecoder->drawSpan != NULL)
 		{
-			switch (p_pif->pifInfo.imageType)
-			{
-				case PIF_TYPE_RGB16C:
-					p_pif->pifDecoder->draw(p_pif->pifDecoder->displayHandle, &(p_pif->pifInfo), _getRGB16C(pixelGroup & 0x0F));
-					break;
-				case PIF_TYPE_BW:
-					p_pif->pifDecoder->draw(p_pif->pifDecoder->displayHandle, &(p_pif->pifInfo), (pixelGroup & 1) ? _getRGB16C(15) : _getRGB16C(0));
-					break;
-				default:
-					p_pif->pifDecoder->draw(p_pif->pifDecoder->displayHandle, &(p_pif->pifInfo), _getIndexedColor(pixelGroup & pixelMask, p_pif, &seek_used));
-					break;
-			}
+			p_pif->pifDecoder->spanBuf[p_pif->spanFill++] = pixel;
 		}
 		else
 		{
-			p_pif->pifDecoder->draw(p_pif->pifDecoder->displayHandle, &(p_pif->pifInfo), pixelGroup & pixelMask);
+			p_pif->pifDecoder->draw(p_pif->pifDecoder->displayHandle, &(p_pif->pifInfo), pixel);
 		}
+	}
+	
+	// Increase Pixel Position counter, spans end at the end of the region's row or when the buffer is full
+	p_pif->pifInfo.currentX++;
+	if (p_pif->spanFill && ((p_pif->spanFill >= p_pif->pifDecoder->spanBufLen) || (p_pif->pifInfo.currentX >= p_pif->pifInfo.regionX + p_pif->pifInfo.regionWidth)))
+	{
+		_flushSpan(p_pif);
+	}
+	if (p_pif->pifInfo.currentX >= p_pif->pifInfo.imageWidth)
+	{
+		p_pif->pifInfo.currentX = 0;
+		p_pif->pifInfo.currentY++;
+	}
+}
+
+/* Hand a run of identical pixels over to the fill function, split at the row boundaries
+ * and clipped to the drawn region */
+static void _fillRun(pifHANDLE_t *p_pif, uint32_t pixel, uint16_t count)
+{
+	const uint16_t regionEndX = p_pif->pifInfo.regionX + p_pif->pifInfo.regionWidth;
+	uint16_t rowLeft, fillStart, fillEnd;
+	
+	// Keep the order of the pixels: Anything collected before the run goes first
+	if (p_pif->spanFill)	_flushSpan(p_pif);
+	
+	while (count && (p_pif->pifInfo.currentY < p_pif->pifInfo.imageHeight))
+	{
+		rowLeft = p_pif->pifInfo.imageWidth - p_pif->pifInfo.currentX;
+		if (rowLeft > count)	rowLeft = count;
 		
-		// Cycle to the next bitgroup that represents a pixel
-		// if none is left to process within the byte, return
-		pixelGroup >>= bitsPerPixel;
-		
-		if (pixelCounter >= 1)
+		if ((uint16_t)(p_pif->pifInfo.currentY - p_pif->pifInfo.regionY) < p_pif->pifInfo.regionHeight)
 		{
-			p_pif->pifInfo.currentX++;
-			if (p_pif->pifInfo.currentX >= p_pif->pifInfo.imageWidth)
+			fillStart = p_pif->pifInfo.currentX;
+			fillEnd = fillStart + rowLeft;
+			if (fillStart < p_pif->pifInfo.regionX)	fillStart = p_pif->pifInfo.regionX;
+			if (fillEnd > regionEndX)	fillEnd = regionEndX;
+			if (fillStart < fillEnd)
 			{
-				p_pif->pifInfo.currentX = 0;
-				p_pif->pifInfo.currentY++;
-				if (p_pif->pifInfo.currentY >= p_pif->pifInfo.imageHeight)
-				{
-					break;
-				}
+				const uint16_t nextX = p_pif->pifInfo.currentX;
+				
+				p_pif->pifInfo.currentX = fillStart;
+				p_pif->pifDecoder->fillRun(p_pif->pifDecoder->displayHandle, &(p_pif->pifInfo), pixel, fillEnd - fillStart);
+				p_pif->pifInfo.currentX = nextX;
 			}
 		}
+		count -= rowLeft;
+		p_pif->pifInfo.currentX += rowLeft;
+		if (p_pif->pifInfo.currentX >= p_pif->pifInfo.imageWidth)
+		{
+			p_pif->pifInfo.currentX = 0;
+			p_pif->pifInfo.currentY++;
+		}
 	}
-	return seek_used;
-}
-
-pifRESULT pif_createPainter(pifPAINT_t *p_painter, PIF_PREPARE_IMAGE *f_optional_prepare, PIF_DRAW_PIXEL *f_draw, PIF_FINISH_IMAGE *f_optional_finish, void *p_displayHandler, uint8_t *p8_opt_ColTableBuf, uint16_t u16_colTableBufLength)
-{
-	p_painter->prepare = f_optional_prepare;
-	p_painter->draw = f_draw;
-	p_painter->finish = f_optional_finish;
-	p_painter->displayHandle = p_displayHandler;
-	p_painter->colTableBuf = p8_opt_ColTableBuf;
-	p_painter->colTableBufLen = u16_colTableBufLength;
-	return (f_draw == NULL) ? PIF_RESULT_DRAWERR : PIF_RESULT_OK;
 }
 
-pifRESULT pif_createIO(pifIO_t *p_fileIO, PIF_OPEN_FILE *f_openFile, PIF_CLOSE_FILE *f_closeFile, PIF_READ_FILE *f_readFile, PIF_SEEK_FILE *f_seekFile)
+/* Bytes per pixel of the RGB formats, the indexed formats count as their color format */
+static inline uint8_t _formatBytes(pifImageType format)
 {
-	p_fileIO->open = f_openFile;
-	p_fileIO->close = f_closeFile;
-	p_fileIO->readByte = f_readFile;
-	p_fileIO->seekPos = f_seekFile;
-	if ((f_openFile == NULL) || (f_readFile == NULL) || (f_seekFile == NULL))
-	{
-		return PIF_RESULT_IOERR;
-	}
-	else
+	switch (format)
 	{
-		return PIF_RESULT_OK;
+		case PIF_TYPE_RGB888:
+		case PIF_TYPE_IND24:
+			return 3;
+		case PIF_TYPE_RGB565:
+		case PIF_TYPE_IND16:
+			return 2;
+		case PIF_TYPE_RGB332:
+		case PIF_TYPE_IND8:
+			return 1;
+		default:
+			return 0;
 	}
 }
 
-void pif_createPIFHandle(pifHANDLE_t *p_PIF, pifIO_t *p_fileIO, pifPAINT_t *p_painter)
+/* Convert a color into the target format, unless it already matches */
+static inline uint32_t _convertIfNeeded(uint32_t color, pifImageType sourceType, pifImageType targetType)
 {
-	p_PIF->pifDecoder = p_painter;
-	p_PIF->pifFileHandler = p_fileIO;
+	if (_formatBytes(sourceType) == _formatBytes(targetType))	return color;
+	return convertColor(color, sourceType, targetType, PIF_CONV_ACCURATE);
 }
 
-// Not only open the image file, but also analyse it and store the information
-pifRESULT pif_open(pifHANDLE_t *p_PIF, const char *pc_path)
+/* Read the palette of an indexed image once, converting the colors into the given format.
+ * Indices past the end of the color table are set to zero */
+static void _expandPalette(pifHANDLE_t *p_pif, uint32_t *p32_lut, uint16_t entries, pifImageType format)
 {
-	int8_t results;
-	uint16_t tempVar;
+	const uint8_t ColorTablePixelSize = p_pif->pifInfo.imageType & PIF_MASK_INDEXED_COLOR_SIZE;
+	uint32_t color;
 	
-	// Open file and check for errors. If there is an error, cancel operation!
-	p_PIF->pifFileHandler->fileHandle = p_PIF->pifFileHandler->open(pc_path, &results);
-	if ((results != 0) || (p_PIF->pifFileHandler->readByte == NULL))
+#if defined(PIF_USE_TABLE_16C)
+	if ((p_pif->pifInfo.imageType == PIF_TYPE_RGB16C) || (p_pif->pifInfo.imageType == PIF_TYPE_BW))
 	{
-		if (p_PIF->pifFileHandler->close != NULL && p_PIF->pifFileHandler->fileHandle != NULL)	p_PIF->pifFileHandler->close(p_PIF->pifFileHandler->fileHandle);
-		return PIF_RESULT_IOERR;
+		// BW and RGB16C use the embedded 16 color table
+		for (uint16_t colorCnt = 0; colorCnt < entries; colorCnt++)
+		{
+			p32_lut[colorCnt] = _convertIfNeeded(_pifGetColor16C(p_pif->pifInfo.imageType, (uint8_t)colorCnt), PIF_RGB16C_FORMAT, format);
+		}
+		return;
 	}
+#endif
 	
-	// Interpret the PIF image header
-	if (_read32(p_PIF->pifFileHandler) != PIF_FORMAT_HEADER)
+	_seek(&(p_pif->pifStream), PIF_FORMAT_COLORTABLE_OFFSET);
+	for (uint16_t colorCnt = 0; colorCnt < entries; colorCnt++)
 	{
-		// Not the file we expected!
-		p_PIF->pifFileHandler->close(&(p_PIF->pifFileHandler->fileHandle));	
-		return PIF_RESULT_FORMATERR;
+		if ((uint32_t)(colorCnt + 1) * ColorTablePixelSize > p_pif->pifInfo.colTableSize)
+		{
+			p32_lut[colorCnt] = 0;
+			continue;
+		}
+		color = _read8(&(p_pif->pifStream));
+		if (ColorTablePixelSize > 1)	color |= (uint32_t)_read8(&(p_pif->pifStream)) << 8;
+		if (ColorTablePixelSize > 2)	color |= (uint32_t)_read8(&(p_pif->pifStream)) << 16;
+		p32_lut[colorCnt] = _convertIfNeeded(color, p_pif->pifInfo.imageType, format);
 	}
+}
+
+/* Look up the color of a single indexed pixel, unless the color table is to be bypassed.
+ * With a palette LUT, the color is returned in the LUT format */
+static inline uint32_t _getIndexedPixel(pifHANDLE_t *p_pif, uint8_t index, const pifImageType imageType)
+{
+	uint32_t color;
 	
-	p_PIF->pifInfo.fileSize = _read32(p_PIF->pifFileHandler);
-	p_PIF->pifInfo.imageOffset = _read32(p_PIF->pifFileHandler);
+	if (p_pif->pifDecoder->bypassColTable != PIF_INDEXED_NORMAL_OPERATION)	return index;
+	if (index < p_pif->colLutUsed)	return p_pif->pifDecoder->colLut[index];
 	
-	tempVar = _read16(p_PIF->pifFileHandler);
-	switch(tempVar)
+	switch (imageType)
 	{
-		case PIF_FORMAT_RGB888:
-			p_PIF->pifInfo.imageType = PIF_TYPE_RGB888;
-			break;
-		case PIF_FORMAT_RGB565:
-			p_PIF->pifInfo.imageType = PIF_TYPE_RGB565;
-			break;
-		case PIF_FORMAT_RGB332:
-			p_PIF->pifInfo.imageType = PIF_TYPE_RGB332;
-			break;
-		case PIF_FORMAT_RGB16C:
-			p_PIF->pifInfo.imageType = PIF_TYPE_RGB16C;
-			break;
-		case PIF_FORMAT_BW:
-			p_PIF->pifInfo.imageType = PIF_TYPE_BW;
-			break;
-		case PIF_FORMAT_IND24:
-			p_PIF->pifInfo.imageType = PIF_TYPE_IND24;
-			break;
-		case PIF_FORMAT_IND16:
-			p_PIF->pifInfo.imageType = PIF_TYPE_IND16;
-			break;
-		case PIF_FORMAT_IND8:
-			p_PIF->pifInfo.imageType = PIF_TYPE_IND8;
+#if defined(PIF_USE_TABLE_16C)
+		case PIF_TYPE_RGB16C:
+		case PIF_TYPE_BW:
+			color = _pifGetColor16C(imageType, index);
 			break;
+#endif
 		default:
-			// Unsupported image type
-			results |= 1;
+			color = _getIndexedColor(index, p_pif);
+			break;
+	}
+	
+	// Colors that don't fit into the LUT are converted one by one
+	if (p_pif->pifDecoder->colLut != NULL)
+	{
+		color = _convertIfNeeded(color, (imageType <= PIF_TYPE_BW) ? PIF_RGB16C_FORMAT : imageType, p_pif->pifDecoder->colLutFormat);
+	}
+	return color;
+}
+
+/* Process the indexed image by looking up the color table */
+static inline void _processIndexed(pifHANDLE_t *p_pif, uint8_t pixelGroup, const pifImageType imageType, const uint8_t bitsPerPixel)
+{
+	uint8_t index[8];
+	uint8_t const pixelLimit = _pifUnpackGroup(pixelGroup, bitsPerPixel, index);
+	
+	if (pixelLimit == 8)
+	{
+		// One bit per pixel: Only two colors to look up for the whole byte
+		uint32_t const color0 = (pixelGroup != 0xFF) ? _getIndexedPixel(p_pif, 0, imageType) : 0;
+		uint32_t const color1 = (pixelGroup != 0x00) ? _getIndexedPixel(p_pif, 1, imageType) : 0;
+		
+		for (uint8_t pixelCounter = 0; pixelCounter < 8; pixelCounter++)
+		{
+			_drawPixel(p_pif, index[pixelCounter] ? color1 : color0);
+		}
+		return;
 	}
-	p_PIF->pifInfo.bitsPerPixel = _read16(p_PIF->pifFileHandler);
-	p_PIF->pifInfo.imageWidth = _read16(p_PIF->pifFileHandler);
-	p_PIF->pifInfo.imageHeight = _read16(p_PIF->pifFileHandler);
-	p_PIF->pifInfo.imageSize = _read32(p_PIF->pifFileHandler);
-	p_PIF->pifInfo.colTableSize = _read16(p_PIF->pifFileHandler);
 	
-	tempVar = _read16(p_PIF->pifFileHandler);
-	if (tempVar == PIF_FORMAT_COMPR)
+	// Look up the colors of the pixels, that are packed within the byte
+	for (uint8_t pixelCounter = 0; pixelCounter < pixelLimit; pixelCounter++)
 	{
-		p_PIF->pifInfo.compression = PIF_COMPRESSION_RLE;
+		_drawPixel(p_pif, _getIndexedPixel(p_pif, index[pixelCounter], imageType));
 	}
-	else if (tempVar == 0)
+}
+
+/* Draw a word of image data: Raw RGB888 / RGB565 / RGB332 directly, anything else is treated as indexed */
+static inline void _processWord(pifHANDLE_t *p_pif, uint32_t pixelData, const pifImageType imageType, const uint8_t bitsPerPixel)
+{
+	if (imageType <= PIF_TYPE_RGB332)
 	{
-		p_PIF->pifInfo.compression = PIF_COMPRESSION_NONE;
+		_drawPixel(p_pif, pixelData);
 	}
 	else
 	{
-		// Unsupported compression
-		results |= 1;
+		_processIndexed(p_pif, pixelData, imageType, bitsPerPixel);
+	}
+}
+
+/* Check if all pixels packed into a byte of indexed image data share the same index.
+ * Returns the amount of pixels within the byte and their index, or zero if they differ */
+static inline uint8_t _getSolidGroup(uint8_t pixelGroup, const uint8_t bitsPerPixel, uint8_t *p8_solidIndex)
+{
+	uint8_t index[8];
+	uint8_t const pixelLimit = _pifUnpackGroup(pixelGroup, bitsPerPixel, index);
+	
+	for (uint8_t pixelCounter = 1; pixelCounter < pixelLimit; pixelCounter++)
+	{
+		if (index[pixelCounter] != index[0])	return 0;
 	}
+	*p8_solidIndex = index[0];
+	return pixelLimit;
+}
+
+/* Check if a word of image data consists of pixels of a single color. Returns the amount
+ * of pixels within the word and their color, or zero for mixed sub-byte pixels */
+static inline uint8_t _getSolidWord(pifHANDLE_t *p_pif, uint32_t pixelData, const pifImageType imageType, const uint8_t bitsPerPixel, uint32_t *p32_pixel)
+{
+	uint8_t pixelLimit, index;
 	
-	p_PIF->pifInfo.startX = 0;
-	p_PIF->pifInfo.startY = 0;
-	p_PIF->pifInfo.currentX = 0;
-	p_PIF->pifInfo.currentY = 0;
+	if (imageType <= PIF_TYPE_RGB332)
+	{
+		*p32_pixel = pixelData;
+		return 1;
+	}
 	
-	if (results)
+	pixelLimit = _getSolidGroup(pixelData, bitsPerPixel, &index);
+	if (pixelLimit)
 	{
-		if (p_PIF->pifFileHandler->close != NULL) p_PIF->pifFileHandler->close(&(p_PIF->pifFileHandler->fileHandle));
-		return PIF_RESULT_FORMATERR;
+		*p32_pixel = _getIndexedPixel(p_pif, index, imageType);
+	}
+	return pixelLimit;
+}
+
+pifRESULT pif_createPainter(pifPAINT_t *p_painter, PIF_PREPARE_IMAGE *f_optional_prepare, PIF_DRAW_PIXEL *f_draw, PIF_FINISH_IMAGE *f_optional_finish, void *p_displayHandler, uint8_t *p8_opt_ColTableBuf, uint16_t u16_colTableBufLength)
+{
+	p_painter->prepare = f_optional_prepare;
+	p_painter->draw = f_draw;
+	p_painter->finish = f_optional_finish;
+	p_painter->displayHandle = p_displayHandler;
+	p_painter->colTableBuf = p8_opt_ColTableBuf;
+	p_painter->colTableBufLen = u16_colTableBufLength;
+	p_painter->drawSpan = NULL;
+	p_painter->spanBuf = NULL;
+	p_painter->spanBufLen = 0;
+	p_painter->fillRun = NULL;
+	p_painter->colLut = NULL;
+	p_painter->colLutLen = 0;
+	pif_setClipping(p_painter, 0, 0, 0xFFFF, 0xFFFF);
+	pif_setDownscaling(p_painter, 1, PIF_SCALE_NEAREST, NULL, 0);
+	pif_setUpscaling(p_painter, 1, NULL, 0);
+	return (f_draw == NULL) ? PIF_RESULT_DRAWERR : PIF_RESULT_OK;
+}
+
+pifRESULT pif_setClipping(pifPAINT_t *p_painter, uint16_t x0, uint16_t y0, uint16_t width, uint16_t height)
+{
+	p_painter->clipX = x0;
+	p_painter->clipY = y0;
+	p_painter->clipWidth = width;
+	p_painter->clipHeight = height;
+	return PIF_RESULT_OK;
+}
+
+pifRESULT pif_setDownscaling(pifPAINT_t *p_painter, uint8_t factor, pifScaleFilter filter, uint16_t *p16_boxBuf, uint16_t u16_boxBufLength)
+{
+	if (((factor != 1) && (factor != 2) && (factor != 4) && (factor != 8)) ||
+		((filter == PIF_SCALE_BOX) && ((p16_boxBuf == NULL) || (u16_boxBufLength == 0))))
+	{
+		p_painter->scaleDown = 1;
+		return PIF_RESULT_DRAWERR;
+	}
+	if (factor > 1)	p_painter->scaleUp = 1;
+	p_painter->scaleDown = factor;
+	p_painter->scaleFilter = filter;
+	p_painter->boxBuf = p16_boxBuf;
+	p_painter->boxBufLen = u16_boxBufLength;
+	return PIF_RESULT_OK;
+}
+
+pifRESULT pif_setUpscaling(pifPAINT_t *p_painter, uint8_t factor, uint32_t *p32_rowBuf, uint16_t u16_rowBufLength)
+{
+	if ((factor == 0) || ((factor > 1) && ((p32_rowBuf == NULL) || (u16_rowBufLength == 0))))
+	{
+		p_painter->scaleUp = 1;
+		return PIF_RESULT_DRAWERR;
+	}
+	if (factor > 1)	p_painter->scaleDown = 1;
+	p_painter->scaleUp = factor;
+	p_painter->rowBuf = p32_rowBuf;
+	p_painter->rowBufLen = u16_rowBufLength;
+	return PIF_RESULT_OK;
+}
+
+pifRESULT pif_setSpanDrawing(pifPAINT_t *p_painter, PIF_DRAW_SPAN *f_drawSpan, uint32_t *p32_spanBuf, uint16_t u16_spanBufLength)
+{
+	if ((f_drawSpan != NULL) && ((p32_spanBuf == NULL) || (u16_spanBufLength == 0)))
+	{
+		p_painter->drawSpan = NULL;
+		return PIF_RESULT_DRAWERR;
+	}
+	p_painter->drawSpan = f_drawSpan;
+	p_painter->spanBuf = p32_spanBuf;
+	p_painter->spanBufLen = u16_spanBufLength;
+	return PIF_RESULT_OK;
+}
+
+pifRESULT pif_setRunFilling(pifPAINT_t *p_painter, PIF_FILL_RUN *f_fillRun)
+{
+	p_painter->fillRun = f_fillRun;
+	return PIF_RESULT_OK;
+}
+
+pifRESULT pif_setColorLUT(pifPAINT_t *p_painter, uint32_t *p32_lut, uint16_t u16_lutLength, pifImageType lutFormat)
+{
+	if ((p32_lut != NULL) && ((u16_lutLength == 0) || (_formatBytes(lutFormat) == 0)))
+	{
+		p_painter->colLut = NULL;
+		return PIF_RESULT_DRAWERR;
+	}
+	p_painter->colLut = p32_lut;
+	p_painter->colLutLen = u16_lutLength;
+	p_painter->colLutFormat = lutFormat;
+	return PIF_RESULT_OK;
+}
+
+pifRESULT pif_createIO(pifIO_t *p_fileIO, PIF_OPEN_FILE *f_openFile, PIF_CLOSE_FILE *f_closeFile, PIF_READ_FILE *f_readFile, PIF_SEEK_FILE *f_seekFile)
+{
+	p_fileIO->open = f_openFile;
+	p_fileIO->close = f_closeFile;
+	p_fileIO->readByte = f_readFile;
+	p_fileIO->readBlock = NULL;
+	p_fileIO->seekPos = f_seekFile;
+	if ((f_openFile == NULL) || (f_readFile == NULL) || (f_seekFile == NULL))
+	{
+		return PIF_RESULT_IOERR;
+	}
+	else
+	{
+		return PIF_RESULT_OK;
+	}
+}
+
+pifRESULT pif_createIOBlock(pifIO_t *p_fileIO, PIF_OPEN_FILE *f_openFile, PIF_CLOSE_FILE *f_closeFile, PIF_READ_BLOCK *f_readBlock, PIF_SEEK_FILE *f_seekFile)
+{
+	pif_createIO(p_fileIO, f_openFile, f_closeFile, NULL, f_seekFile);
+	p_fileIO->readBlock = f_readBlock;
+	if ((f_openFile == NULL) || (f_readBlock == NULL) || (f_seekFile == NULL))
+	{
+		return PIF_RESULT_IOERR;
+	}
+	else
+	{
+		return PIF_RESULT_OK;
+	}
+}
+
+pifRESULT pif_setReadBuffer(pifHANDLE_t *p_PIF, uint8_t *p8_readBuf, uint16_t u16_readBufLength)
+{
+	pifSTREAM_t * const p_io = &(p_PIF->pifStream);
+	
+	p_io->readBufPos = 0;
+	p_io->readBufFill = 0;
+	if ((p8_readBuf != NULL) && (u16_readBufLength == 0))
+	{
+		p_io->readBuf = NULL;
+		p_io->readBufLen = 0;
+		return PIF_RESULT_IOERR;
+	}
+	p_io->readBuf = (u16_readBufLength) ? p8_readBuf : NULL;
+	p_io->readBufLen = u16_readBufLength;
+	return PIF_RESULT_OK;
+}
+
+void pif_createPIFHandle(pifHANDLE_t *p_PIF, const pifIO_t *p_fileIO, const pifPAINT_t *p_painter)
+{
+	p_PIF->pifDecoder = p_painter;
+	memset(&(p_PIF->pifStream), 0, sizeof(pifSTREAM_t));
+	p_PIF->pifStream.fileIO = p_fileIO;
+	p_PIF->spanFill = 0;
+	p_PIF->colLutUsed = 0;
+#if PIF_COLOR_CACHE_SIZE > 0
+	memset(&(p_PIF->colCache), 0, sizeof(pifCOLORCACHE_t));
+#endif
+	p_PIF->rowIndex = NULL;
+	p_PIF->rowIndexStep = 0;
+	p_PIF->stepping = 0;
+	p_PIF->dataError = 0;
+	p_PIF->scaleShift = 0;
+	p_PIF->scaleUp = 0;
+}
+
+/* Parse the image header at the current reading position (start of the file) */
+static pifRESULT _parseHeader(pifHANDLE_t *p_PIF)
+{
+	uint8_t header[PIF_FORMAT_COLORTABLE_OFFSET];
+	pifRESULT result;
+	
+	// The whole header in one go, a single block read instead of one per field
+	_readBytes(&(p_PIF->pifStream), header, PIF_FORMAT_COLORTABLE_OFFSET);
+	result = _pifDecodeHeader(header, &(p_PIF->pifInfo));
+	if (_pifGet32(&header[0]) != PIF_FORMAT_HEADER)	return result;
+	
+	// A row index and an image drawn in steps belong to the previously opened image
+	p_PIF->rowIndex = NULL;
+	p_PIF->rowIndexStep = 0;
+	p_PIF->stepping = 0;
+	p_PIF->scaleShift = 0;
+	p_PIF->scaleUp = 0;
+	
+	// Look for a row index between the color table and the image data. Older decoders skip it through imageOffset
+	if (p_PIF->pifInfo.imageOffset >= (uint32_t)PIF_FORMAT_COLORTABLE_OFFSET + p_PIF->pifInfo.colTableSize + PIF_FORMAT_ROWINDEX_HEADER)
+	{
+		uint8_t data8[PIF_FORMAT_ROWINDEX_HEADER];
+		uint16_t step, entries;
+		
+		_readAt(&(p_PIF->pifStream), PIF_FORMAT_COLORTABLE_OFFSET + p_PIF->pifInfo.colTableSize, data8, PIF_FORMAT_ROWINDEX_HEADER);
+		step = _pifGet16(&data8[4]);
+		entries = _pifGet16(&data8[6]);
+		
+		if ((data8[0] == 'R') && (data8[1] == 'I') && (data8[2] == 'D') && (data8[3] == 'X') && step &&
+			(entries == ((uint32_t)p_PIF->pifInfo.imageHeight + step - 1) / step) &&
+			(p_PIF->pifInfo.imageOffset >= PIF_FORMAT_COLORTABLE_OFFSET + p_PIF->pifInfo.colTableSize + PIF_FORMAT_ROWINDEX_HEADER + (uint32_t)entries * PIF_FORMAT_ROWINDEX_ENTRY))
+		{
+			p_PIF->pifInfo.fileRowIndexStep = step;
+		}
+	}
+	
+	// The image data is the last thing required from the file
+	if (p_PIF->pifStream.memLen == 0)	p_PIF->pifStream.ioLimit = p_PIF->pifInfo.imageOffset + p_PIF->pifInfo.imageSize;
+	
+	return result;
+}
+
+
+// Not only open the image file, but also analyse it and store the information
+pifRESULT pif_open(pifHANDLE_t *p_PIF, const char *pc_path)
+{
+	int8_t results;
+	pifRESULT headerResult;
+	
+	// Any previously opened image from memory is replaced by the file
+	p_PIF->pifStream.memLen = 0;
+	
+	// Open file and check for errors. If there is an error, cancel operation!
+	p_PIF->pifStream.fileHandle = p_PIF->pifStream.fileIO->open(pc_path, &results);
+	if ((results != 0) || ((p_PIF->pifStream.fileIO->readByte == NULL) && (p_PIF->pifStream.fileIO->readBlock == NULL)))
+	{
+		if (p_PIF->pifStream.fileIO->close != NULL && p_PIF->pifStream.fileHandle != NULL)	p_PIF->pifStream.fileIO->close(p_PIF->pifStream.fileHandle);
+		return PIF_RESULT_IOERR;
+	}
+	
+	// Freshly opened file, don't read ahead further than the header until it's known how large the image is
+	p_PIF->pifStream.ioPos = 0;
+	p_PIF->pifStream.ioLimit = PIF_FORMAT_COLORTABLE_OFFSET;
+	p_PIF->pifStream.readBufPos = 0;
+	p_PIF->pifStream.readBufFill = 0;
+	
+	headerResult = _parseHeader(p_PIF);
+	if (headerResult != PIF_RESULT_OK)
+	{
+		if (p_PIF->pifStream.fileIO->close != NULL)	p_PIF->pifStream.fileIO->close(p_PIF->pifStream.fileHandle);
+	}
+	return headerResult;
+}
+
+/* Common part of opening an image from RAM or flash */
+static pifRESULT _openMemory(pifHANDLE_t *p_PIF, size_t length)
+{
+	p_PIF->pifStream.memLen = length;
+	p_PIF->pifStream.fileHandle = NULL;
+	p_PIF->pifStream.ioPos = 0;
+	p_PIF->pifStream.ioLimit = length;
+	p_PIF->pifStream.readBufPos = 0;
+	p_PIF->pifStream.readBufFill = 0;
+	
+	return _parseHeader(p_PIF);
+}
+
+/* Keep the image data of a whole image in memory within the array. Image data starting
+ * beyond it can't be right, a cut off image is decoded as far as it goes */
+static pifRESULT _limitToMemory(pifHANDLE_t *p_PIF, pifRESULT result, size_t length)
+{
+	if (result != PIF_RESULT_OK)	return result;
+	if (p_PIF->pifInfo.imageOffset > length)	return PIF_RESULT_FORMATERR;
+	if (p_PIF->pifInfo.imageSize > length - p_PIF->pifInfo.imageOffset)
+	{
+		p_PIF->pifInfo.imageSize = length - p_PIF->pifInfo.imageOffset;
+	}
+	return PIF_RESULT_OK;
+}
+
+// Images in memory are read straight from the array, no I/O functions are involved
+pifRESULT pif_openMemory(pifHANDLE_t *p_PIF, const uint8_t *p8_data, size_t length)
+{
+	if ((p8_data == NULL) || (length < PIF_FORMAT_COLORTABLE_OFFSET))	return PIF_RESULT_IOERR;
+	
+	p_PIF->pifStream.memData = p8_data;
+#if defined(AVR)
+	p_PIF->pifStream.memFlashAddr = 0;
+#endif
+	return _limitToMemory(p_PIF, _openMemory(p_PIF, length), length);
+}
+
+#if defined(AVR)
+pifRESULT pif_openMemory_P(pifHANDLE_t *p_PIF, uint32_t u32_flashAddr, size_t length)
+{
+	if ((u32_flashAddr == 0) || (length < PIF_FORMAT_COLORTABLE_OFFSET))	return PIF_RESULT_IOERR;
+	
+	p_PIF->pifStream.memData = NULL;
+	p_PIF->pifStream.memFlashAddr = u32_flashAddr;
+	return _limitToMemory(p_PIF, _openMemory(p_PIF, length), length);
+}
+#endif
+
+// Only the header, for listing images without opening them
+pifRESULT pif_probe(const uint8_t p8_header[PIF_HEADER_SIZE], pifINFO_t *p_info)
+{
+	if ((p8_header == NULL) || (p_info == NULL))	return PIF_RESULT_FORMATERR;
+	
+	return _pifDecodeHeader(p8_header, p_info);
+}
+
+// FNV-1a over the path. Case and the kind of slashes don't matter, just like on FAT file systems
+uint32_t pif_catalogHash(const char *pc_path)
+{
+	uint32_t hash = 2166136261UL;
+	char c;
+	
+	if (pc_path == NULL)	return hash;
+	while ((*pc_path == '/') || (*pc_path == '\\'))	pc_path++;
+	while ((c = *pc_path++) != '\0')
+	{
+		if (c == '\\')	c = '/';
+		else if ((c >= 'A') && (c <= 'Z'))	c += 'a' - 'A';
+		hash = (hash ^ (uint8_t)c) * 16777619UL;
+	}
+	return hash;
+}
+
+/* Binary search for the hash of the path in a catalog, in RAM or in the AVR program memory */
+static pifRESULT _catalogFind(pifSTREAM_t *p_io, const char *pc_path, pifINFO_t *p_info)
+{
+	uint8_t data8[PIF_CATALOG_ENTRY];
+	uint32_t hash = pif_catalogHash(pc_path);
+	uint32_t entries, low = 0, high, mid;
+	uint16_t entrySize;
+	
+	_readAt(p_io, 0, data8, PIF_CATALOG_HEADER);
+	entrySize = _pifGet16(&data8[6]);
+	entries = _pifGet32(&data8[8]);
+	if ((_pifGet32(&data8[0]) != PIF_CATALOG_MAGIC) || (_pifGet16(&data8[4]) != PIF_CATALOG_VERSION) ||
+		(entrySize < PIF_CATALOG_ENTRY) || (entries > (p_io->memLen - PIF_CATALOG_HEADER) / entrySize))
+	{
+		return PIF_RESULT_FORMATERR;
+	}
+	
+	// The entries are sorted by their hash, and the catalog tool doesn't allow two paths with the same hash
+	high = entries;
+	while (low < high)
+	{
+		mid = low + (high - low) / 2;
+		_readAt(p_io, PIF_CATALOG_HEADER + mid * entrySize, data8, 4);
+		if (_pifGet32(data8) < hash)	low = mid + 1;
+		else						high = mid;
+	}
+	if (low == entries)	return PIF_RESULT_IOERR;
+	
+	_readAt(p_io, PIF_CATALOG_HEADER + low * entrySize, data8, PIF_CATALOG_ENTRY);
+	if (_pifGet32(data8) != hash)	return PIF_RESULT_IOERR;
+	
+	// Put the magic back in place of the hash, the entry is then checked like the header of the file itself
+	data8[0] = 'P';
+	data8[1] = 'I';
+	data8[2] = 'F';
+	data8[3] = '\0';
+	return _pifDecodeHeader(data8, p_info);
+}
+
+// Image information out of a catalog in RAM or memory mapped flash, without touching the image file
+pifRESULT pif_catalogFind(const uint8_t *p8_catalog, size_t length, const char *pc_path, pifINFO_t *p_info)
+{
+	pifSTREAM_t catalog;
+	
+	if ((p8_catalog == NULL) || (length < PIF_CATALOG_HEADER))	return PIF_RESULT_FORMATERR;
+	
+	memset(&catalog, 0, sizeof(catalog));
+	catalog.memData = p8_catalog;
+	catalog.memLen = length;
+	return _catalogFind(&catalog, pc_path, p_info);
+}
+
+#if defined(AVR)
+pifRESULT pif_catalogFind_P(uint32_t u32_flashAddr, size_t length, const char *pc_path, pifINFO_t *p_info)
+{
+	pifSTREAM_t catalog;
+	
+	if ((u32_flashAddr == 0) || (length < PIF_CATALOG_HEADER))	return PIF_RESULT_FORMATERR;
+	
+	memset(&catalog, 0, sizeof(catalog));
+	catalog.memFlashAddr = u32_flashAddr;
+	catalog.memLen = length;
+	return _catalogFind(&catalog, pc_path, p_info);
+}
+#endif
+
+/* Turn the byte read at an instruction into the RLE instruction. Extended RLE stores runs and
+ * literal blocks of more than 127 words as a zero byte, followed by the count as int16.
+ * An invalid count ends the image data, the decoding functions report it as format error */
+static inline int16_t _rleInstr(pifHANDLE_t *p_pif, uint8_t instr)
+{
+	int16_t rleInstr;
+	
+	if ((instr == 0) && (p_pif->pifInfo.compression == PIF_COMPRESSION_RLE_EXT))
+	{
+		p_pif->pifStream.filePos += 2;
+		rleInstr = _pifExtInstr(_read16(&(p_pif->pifStream)));
+		if (rleInstr == 0)
+		{
+			p_pif->dataError = 1;
+			p_pif->pifStream.filePos = p_pif->pifInfo.imageSize;
+		}
+		return rleInstr;
+	}
+	return (int8_t)instr;
+}
+
+/* Check if a run of pixels, starting at the current position, misses the drawn region completely */
+static inline uint8_t _isRunHidden(pifINFO_t *p_info, uint16_t count)
+{
+	const uint32_t lastX = (uint32_t)p_info->currentX + count - 1;
+	
+	if (p_info->currentY >= p_info->regionY + p_info->regionHeight)	return 1;
+	if (lastX < p_info->imageWidth)
+	{
+		// Run within a single row
+		return (p_info->currentY < p_info->regionY) || (lastX < p_info->regionX) || (p_info->currentX >= p_info->regionX + p_info->regionWidth);
+	}
+	// Runs across rows are only skipped if they end above the region
+	return (p_info->currentY + lastX / p_info->imageWidth) < p_info->regionY;
+}
+
+/* Move the position over a run of pixels without drawing them */
+static inline void _skipPixels(pifINFO_t *p_info, uint16_t count)
+{
+	const uint32_t nextX = (uint32_t)p_info->currentX + count;
+	
+	p_info->currentY += nextX / p_info->imageWidth;
+	p_info->currentX = nextX % p_info->imageWidth;
+}
+
+/* Read an entry of the row index stored in the file, converted to the format of pif_buildRowIndex */
+static void _readFileRowIndex(pifHANDLE_t *p_PIF, uint16_t entry, uint32_t *p32_entry)
+{
+	uint8_t data8[PIF_FORMAT_ROWINDEX_ENTRY];
+	
+	_readAt(&(p_PIF->pifStream), PIF_FORMAT_COLORTABLE_OFFSET + p_PIF->pifInfo.colTableSize + PIF_FORMAT_ROWINDEX_HEADER +
+		(uint32_t)entry * PIF_FORMAT_ROWINDEX_ENTRY, data8, PIF_FORMAT_ROWINDEX_ENTRY);
+	p32_entry[0] = p_PIF->pifInfo.imageOffset + (data8[0] | ((uint32_t)data8[1] << 8) | ((uint32_t)data8[2] << 16) | ((uint32_t)data8[3] << 24));
+	p32_entry[1] = data8[4] | ((uint16_t)data8[5] << 8);
+}
+
+/* Rows between two entries of the row index in use. An index attached to the handle is preferred over the one stored in the file */
+static inline uint16_t _rowIndexStep(pifHANDLE_t *p_PIF)
+{
+	return (p_PIF->rowIndex != NULL) ? p_PIF->rowIndexStep : p_PIF->pifInfo.fileRowIndexStep;
+}
+
+/* Get an entry of the row index in use */
+static void _getRowIndex(pifHANDLE_t *p_PIF, uint16_t entry, uint32_t *p32_entry)
+{
+	if (p_PIF->rowIndex != NULL)
+	{
+		p32_entry[0] = p_PIF->rowIndex[2 * entry];
+		p32_entry[1] = p_PIF->rowIndex[2 * entry + 1];
+	}
+	else
+	{
+		_readFileRowIndex(p_PIF, entry, p32_entry);
+	}
+}
+
+/* Start decoding a RLE image at the last indexed row above the region, instead of the
+ * start of the image. The pixels of the run in front of that row are skipped as usual */
+static void _seekRowIndex(pifHANDLE_t *p_PIF, uint16_t indexStep)
+{
+	const uint16_t entry = p_PIF->pifInfo.regionY / indexStep;
+	uint32_t indexEntry[2];
+	uint32_t startPixel;
+	
+	_getRowIndex(p_PIF, entry, indexEntry);
+	startPixel = (uint32_t)entry * indexStep * p_PIF->pifInfo.imageWidth - indexEntry[1];
+	
+	_seek(&(p_PIF->pifStream), indexEntry[0]);
+	p_PIF->pifStream.filePos = indexEntry[0] - p_PIF->pifInfo.imageOffset;
+	p_PIF->pifInfo.currentY = startPixel / p_PIF->pifInfo.imageWidth;
+	p_PIF->pifInfo.currentX = startPixel % p_PIF->pifInfo.imageWidth;
+}
+
+/* Check if the position lies in front of the end of a time slice */
+static inline uint8_t _isBeforeStop(const pifINFO_t *p_info, uint16_t stopY, uint16_t stopX)
+{
+	return (p_info->currentY < stopY) || ((p_info->currentY == stopY) && (p_info->currentX < stopX));
+}
+
+/* Decode the image data and send it to the display. Always inlined with constant image type
+ * and bits per pixel (except for indexed images), so the compiler generates a specialized
+ * loop for every enabled format without testing the format for every pixel.
+ * Stops after about pixelBudget pixels, the state to continue with is kept in the handle.
+ * Returns non-zero once the whole region has been decoded */
+static _PIF_ALWAYS_INLINE uint8_t _decodeImage(pifHANDLE_t *p_PIF, const pifImageType imageType, const uint8_t bitsPerPixel, uint32_t pixelBudget)
+{
+	int16_t rleInstr = 0;
+	uint32_t pixelData;
+	uint32_t runPixel;
+	uint8_t pixelsPerWord;
+	uint16_t stopY = 0xFFFF, stopX = 0;
+	uint32_t position;
+	
+	const uint8_t filePosInc = _pifWordBytes(bitsPerPixel);
+	const uint8_t wordPixels = _pifWordPixels(bitsPerPixel);
+	const uint16_t regionEndY = p_PIF->pifInfo.regionY + p_PIF->pifInfo.regionHeight;
+	const uint16_t indexStep = _rowIndexStep(p_PIF);
+	
+	// Image position at which the time slice ends, unless the image ends before
+	position = (uint32_t)p_PIF->pifInfo.currentY * p_PIF->pifInfo.imageWidth + p_PIF->pifInfo.currentX;
+	if (pixelBudget < (uint32_t)p_PIF->pifInfo.imageWidth * p_PIF->pifInfo.imageHeight - position)
+	{
+		position += pixelBudget;
+		stopY = position / p_PIF->pifInfo.imageWidth;
+		stopX = position % p_PIF->pifInfo.imageWidth;
+	}
+	
+	if (p_PIF->pifInfo.compression != PIF_COMPRESSION_NONE)
+	{
+		if (indexStep && (p_PIF->pifInfo.regionY >= indexStep) && (p_PIF->pifStream.filePos == 0))	_seekRowIndex(p_PIF, indexStep);
+		
+		// Decoding ends with the last row of the region, time slices end in front of an RLE instruction
+		for (; (p_PIF->pifStream.filePos < p_PIF->pifInfo.imageSize) && (p_PIF->pifInfo.currentY < regionEndY) &&
+			((rleInstr != 0) || _isBeforeStop(&(p_PIF->pifInfo), stopY, stopX)); p_PIF->pifStream.filePos++)
+		{
+			// Load the next byte			
+			pixelData = _read8(&(p_PIF->pifStream));
+			
+			// Check the RLE Instruction
+			if (rleInstr != 0)
+			{
+				// Load additional bytes if RGB565 or RGB888 is used
+				if (bitsPerPixel > 16)
+				{
+					pixelData |= (uint32_t)_read16(&(p_PIF->pifStream)) << 8;
+					p_PIF->pifStream.filePos += 2;
+				}
+				else if (bitsPerPixel > 8)
+				{
+					pixelData |= (uint32_t)_read8(&(p_PIF->pifStream)) << 8;
+					p_PIF->pifStream.filePos++;
+				}
+			}
+			
+			if (rleInstr > 0)
+			{
+				// RLE Instruction is positive: Send the pixel rleInst-amount of times,
+				// or fill the whole run at once if it consists of a single color
+				if (_isRunHidden(&(p_PIF->pifInfo), (uint16_t)rleInstr * wordPixels))
+				{
+					_skipPixels(&(p_PIF->pifInfo), (uint16_t)rleInstr * wordPixels);
+					rleInstr = 0;
+				}
+				else if ((p_PIF->pifDecoder->fillRun != NULL) && (pixelsPerWord = _getSolidWord(p_PIF, pixelData, imageType, bitsPerPixel, &runPixel)))
+				{
+					_fillRun(p_PIF, runPixel, (uint16_t)rleInstr * pixelsPerWord);
+					rleInstr = 0;
+				}
+				for (; rleInstr > 0; rleInstr--)
+				{
+					_processWord(p_PIF, pixelData, imageType, bitsPerPixel);
+				}
+			}
+			else if (rleInstr < 0)
+			{
+				// RLE Instruction is negative: The next (rleInst * -1)-amount of image pixels are uncompressed
+				_processWord(p_PIF, pixelData, imageType, bitsPerPixel);
+				rleInstr++;
+			}
+			else
+			{
+				// RLE Instruction is zero / empty - load the next RLE instruction
+				rleInstr = _rleInstr(p_PIF, (uint8_t)pixelData);
+				
+				// Uncompressed words outside of the region are skipped without reading them
+				if ((rleInstr < 0) && _isRunHidden(&(p_PIF->pifInfo), (uint16_t)(-rleInstr) * wordPixels))
+				{
+					const uint16_t literalBytes = (uint16_t)(-rleInstr) * filePosInc;
+					
+					_seek(&(p_PIF->pifStream), _tell(&(p_PIF->pifStream)) + literalBytes);
+					p_PIF->pifStream.filePos += literalBytes;
+					_skipPixels(&(p_PIF->pifInfo), (uint16_t)(-rleInstr) * wordPixels);
+					rleInstr = 0;
+				}
+			}
+		}
+		return (p_PIF->pifStream.filePos >= p_PIF->pifInfo.imageSize) || (p_PIF->pifInfo.currentY >= regionEndY);
+	}
+	else
+	{
+		// Only the words holding pixels of the region are read, anything else is skipped by seeking.
+		// Images with whole bytes per pixel are pulled row by row out of the read-ahead buffer, if it is large enough
+		const uint16_t regionEndX = p_PIF->pifInfo.regionX + p_PIF->pifInfo.regionWidth;
+		uint32_t nextWord = p_PIF->nextWord;		// Index of the next word in the file
+		uint32_t firstWord, rowEnd, rowWords;
+		const uint8_t *p8_row;
+		uint16_t y;
+		
+		// Time slices end with whole rows
+		for (y = p_PIF->nextRow; (y < regionEndY) && _isBeforeStop(&(p_PIF->pifInfo), stopY, stopX); y++)
+		{
+			// Sub-byte pixels aren't aligned to the rows, the last word of a row may already hold the next row
+			firstWord = ((uint32_t)y * p_PIF->pifInfo.imageWidth + p_PIF->pifInfo.regionX) / wordPixels;
+			rowEnd = (uint32_t)y * p_PIF->pifInfo.imageWidth + regionEndX;
+			if (firstWord > nextWord)
+			{
+				_seek(&(p_PIF->pifStream), p_PIF->pifInfo.imageOffset + firstWord * filePosInc);
+				nextWord = firstWord;
+				p_PIF->pifInfo.currentY = (nextWord * wordPixels) / p_PIF->pifInfo.imageWidth;
+				p_PIF->pifInfo.currentX = (nextWord * wordPixels) % p_PIF->pifInfo.imageWidth;
+			}
+			rowWords = (nextWord * wordPixels < rowEnd) ? (rowEnd - nextWord * wordPixels + wordPixels - 1) / wordPixels : 0;
+			nextWord += rowWords;
+			p_PIF->pifStream.filePos += rowWords * filePosInc;
+			
+			p8_row = (bitsPerPixel >= 8) ? _readRow(&(p_PIF->pifStream), rowWords * filePosInc) : NULL;
+			if (p8_row != NULL)
+			{
+				for (; rowWords; rowWords--)
+				{
+					pixelData = *p8_row++;
+					if (bitsPerPixel > 8)	pixelData |= (uint32_t)(*p8_row++) << 8;
+					if (bitsPerPixel > 16)	pixelData |= (uint32_t)(*p8_row++) << 16;
+					_processWord(p_PIF, pixelData, imageType, bitsPerPixel);
+				}
+				continue;
+			}
+			
+			for (; rowWords; rowWords--)
+			{
+				if (bitsPerPixel > 16)
+				{
+					pixelData = _read24(&(p_PIF->pifStream));
+				}
+				else if (bitsPerPixel > 8)
+				{
+					pixelData = _read16(&(p_PIF->pifStream));
+				}
+				else
+				{
+					pixelData = _read8(&(p_PIF->pifStream));
+				}
+				_processWord(p_PIF, pixelData, imageType, bitsPerPixel);
+			}
+		}
+		p_PIF->nextRow = y;
+		p_PIF->nextWord = nextWord;
+		return y >= regionEndY;
+	}
+}
+
+/* Bytes per pixel of the colors handed to the display, zero for raw indices */
+static uint8_t _displayBytes(pifHANDLE_t *p_pif)
+{
+	const pifImageType imageType = p_pif->pifInfo.imageType;
+	
+	if (imageType <= PIF_TYPE_RGB332)	return _formatBytes(imageType);
+	if (p_pif->pifDecoder->bypassColTable != PIF_INDEXED_NORMAL_OPERATION)	return 0;
+	if (p_pif->pifDecoder->colLut != NULL)	return _formatBytes(p_pif->pifDecoder->colLutFormat);
+	if ((imageType == PIF_TYPE_RGB16C) || (imageType == PIF_TYPE_BW))	return _formatBytes(PIF_RGB16C_FORMAT);
+	return _formatBytes(imageType);
+}
+
+/* Return to the size of the image in the file, once a scaled image is done */
+static void _endScaling(pifHANDLE_t *p_pif)
+{
+	if ((p_pif->scaleShift == 0) && (p_pif->scaleUp == 0))	return;
+	p_pif->pifInfo.imageWidth = p_pif->srcWidth;
+	p_pif->pifInfo.imageHeight = p_pif->srcHeight;
+	p_pif->scaleShift = 0;
+	p_pif->scaleUp = 0;
+}
+
+/* First and last column (or row) of the image in the file, that contribute to the scaled
+ * columns (or rows) start to start + length - 1 */
+static void _sourceRange(pifHANDLE_t *p_pif, uint16_t start, uint16_t length, uint16_t sourceSize, uint16_t *p16_first, uint16_t *p16_last)
+{
+	const uint32_t end = (uint32_t)start + length;
+	
+	if (p_pif->scaleUp)
+	{
+		*p16_first = start / p_pif->scaleUp;
+		*p16_last = (end - 1) / p_pif->scaleUp;
+	}
+	else if (p_pif->scaleBytes)
+	{
+		*p16_first = (uint32_t)start << p_pif->scaleShift;
+		*p16_last = ((end << p_pif->scaleShift) < sourceSize) ? (end << p_pif->scaleShift) - 1 : (uint32_t)sourceSize - 1;
+	}
+	else
+	{
+		// Nearest neighbour only uses the first pixel of the last block
+		*p16_first = (uint32_t)start << p_pif->scaleShift;
+		*p16_last = (end - 1) << p_pif->scaleShift;
+	}
+}
+
+/* Check if a row of the image in the file contributes to the scaled region */
+static inline uint8_t _isRowScaled(pifHANDLE_t *p_pif, uint16_t y)
+{
+	uint16_t firstRow, lastRow;
+	
+	_sourceRange(p_pif, p_pif->pifInfo.regionY, p_pif->pifInfo.regionHeight, p_pif->srcHeight, &firstRow, &lastRow);
+	if ((y < firstRow) || (y > lastRow))	return 0;
+	// Nearest neighbour only uses the top row of every block
+	return p_pif->scaleBytes || !(y & ((1 << p_pif->scaleShift) - 1));
+}
+
+/* Check if a run of pixels of the image in the file, starting at the current position, misses the scaled region */
+static uint8_t _isScaledRunHidden(pifHANDLE_t *p_pif, uint16_t count)
+{
+	const uint8_t shift = p_pif->scaleShift;
+	const uint32_t lastX = (uint32_t)p_pif->srcX + count - 1;
+	uint16_t first, last;
+	uint32_t y, lastY;
+	
+	if (lastX < p_pif->srcWidth)
+	{
+		// Run within a single row, for nearest neighbour it has to cover the first column of a block
+		if (!_isRowScaled(p_pif, p_pif->srcY))	return 1;
+		_sourceRange(p_pif, p_pif->pifInfo.regionX, p_pif->pifInfo.regionWidth, p_pif->srcWidth, &first, &last);
+		if ((lastX < first) || (p_pif->srcX > last))	return 1;
+		return (p_pif->scaleBytes == 0) && ((((uint32_t)p_pif->srcX + (1 << shift) - 1) >> shift) > (lastX >> shift));
+	}
+	
+	// Runs across rows are only skipped if none of their rows is used
+	_sourceRange(p_pif, p_pif->pifInfo.regionY, p_pif->pifInfo.regionHeight, p_pif->srcHeight, &first, &last);
+	lastY = p_pif->srcY + lastX / p_pif->srcWidth;
+	if (lastY > last)	lastY = last;
+	y = (first > p_pif->srcY) ? first : p_pif->srcY;
+	if (p_pif->scaleBytes == 0)	y = (y + (1 << shift) - 1) & ~(uint32_t)((1 << shift) - 1);
+	return y > lastY;
+}
+
+/* Move the position within the image in the file over a run of pixels */
+static inline void _scaleSkip(pifHANDLE_t *p_pif, uint16_t count)
+{
+	const uint32_t nextX = (uint32_t)p_pif->srcX + count;
+	
+	p_pif->srcY += nextX / p_pif->srcWidth;
+	p_pif->srcX = nextX % p_pif->srcWidth;
+}
+
+/* Draw count pixels of the scaled image, starting at the given position */
+static void _scaleEmit(pifHANDLE_t *p_pif, uint32_t pixel, uint16_t x, uint16_t y, uint16_t count)
+{
+	// Spans only hold consecutive pixels
+	if ((p_pif->pifInfo.currentX != x) || (p_pif->pifInfo.currentY != y))
+	{
+		if (p_pif->spanFill)	_flushSpan(p_pif);
+		p_pif->pifInfo.currentX = x;
+		p_pif->pifInfo.currentY = y;
+	}
+	if ((count > 1) && (p_pif->pifDecoder->fillRun != NULL))
+	{
+		_fillRun(p_pif, pixel, count);
+		return;
+	}
+	for (; count; count--)
+	{
+		_drawPixel(p_pif, pixel);
+	}
+}
+
+/* Bit positions and masks of the color channels of RGB332, RGB565 and RGB888, averaged by the box filter */
+static const uint8_t boxShift[3][3] = {{5, 2, 0}, {11, 5, 0}, {16, 8, 0}};
+static const uint8_t boxMask[3][3] = {{0x07, 0x07, 0x03}, {0x1F, 0x3F, 0x1F}, {0xFF, 0xFF, 0xFF}};
+
+/* Draw the averaged row of blocks collected by the box filter */
+static void _boxEmit(pifHANDLE_t *p_pif)
+{
+	const uint8_t shift = p_pif->scaleShift;
+	const uint8_t format = p_pif->scaleBytes - 1;
+	const uint16_t regionEndX = p_pif->pifInfo.regionX + p_pif->pifInfo.regionWidth;
+	const uint32_t blockSize = 1 << shift;
+	const uint32_t blockTop = (uint32_t)p_pif->boxRow << shift;
+	const uint8_t blockHeight = (p_pif->srcHeight - blockTop < blockSize) ? p_pif->srcHeight - blockTop : blockSize;
+	uint16_t *p16_sum = p_pif->pifDecoder->boxBuf;
+	uint8_t blockWidth, channel;
+	uint16_t pixels;
+	uint32_t pixel;
+	
+	for (uint16_t x = p_pif->pifInfo.regionX; x < regionEndX; x++)
+	{
+		blockWidth = (p_pif->srcWidth - ((uint32_t)x << shift) < blockSize) ? p_pif->srcWidth - ((uint32_t)x << shift) : blockSize;
+		pixels = (uint16_t)blockWidth * blockHeight;
+		pixel = 0;
+		for (channel = 0; channel < 3; channel++)
+		{
+			pixel |= (uint32_t)((*p16_sum + pixels / 2) / pixels) << boxShift[format][channel];
+			*p16_sum++ = 0;
+		}
+		_scaleEmit(p_pif, pixel, x, p_pif->boxRow, 1);
+	}
+	p_pif->boxRow = 0xFFFF;
+}
+
+/* Add a run of pixels within a row to the sums of the box filter */
+static void _boxAdd(pifHANDLE_t *p_pif, uint32_t pixel, uint16_t count)
+{
+	const uint8_t shift = p_pif->scaleShift;
+	const uint8_t format = p_pif->scaleBytes - 1;
+	const uint16_t blockRow = p_pif->srcY >> shift;
+	const uint32_t runEnd = (uint32_t)p_pif->srcX + count;
+	uint32_t x = p_pif->srcX >> shift, lastX = (runEnd - 1) >> shift, from, to;
+	uint16_t *p16_sum;
+	uint8_t channel;
+	
+	// The previous row of blocks is complete once the next one starts
+	if (p_pif->boxRow != blockRow)
+	{
+		if (p_pif->boxRow != 0xFFFF)	_boxEmit(p_pif);
+		p_pif->boxRow = blockRow;
+	}
+	
+	if (x < p_pif->pifInfo.regionX)	x = p_pif->pifInfo.regionX;
+	if (lastX >= (uint32_t)p_pif->pifInfo.regionX + p_pif->pifInfo.regionWidth)	lastX = p_pif->pifInfo.regionX + p_pif->pifInfo.regionWidth - 1;
+	for (; x <= lastX; x++)
+	{
+		// Amount of the pixels lying within the block
+		from = (x << shift > p_pif->srcX) ? x << shift : p_pif->srcX;
+		to = ((x + 1) << shift < runEnd) ? (x + 1) << shift : runEnd;
+		p16_sum = p_pif->pifDecoder->boxBuf + 3 * (x - p_pif->pifInfo.regionX);
+		for (channel = 0; channel < 3; channel++)
+		{
+			p16_sum[channel] += ((pixel >> boxShift[format][channel]) & boxMask[format][channel]) * (to - from);
+		}
+	}
+}
+
+/* Draw the columns first to last of the image in the file enlarged on a row of the scaled image */
+static inline void _upscaleEmit(pifHANDLE_t *p_pif, uint32_t pixel, uint16_t first, uint16_t last, uint16_t y)
+{
+	const uint32_t regionEndX = (uint32_t)p_pif->pifInfo.regionX + p_pif->pifInfo.regionWidth;
+	uint32_t x = (uint32_t)first * p_pif->scaleUp, endX = ((uint32_t)last + 1) * p_pif->scaleUp;
+	
+	if (x < p_pif->pifInfo.regionX)	x = p_pif->pifInfo.regionX;
+	if (endX > regionEndX)	endX = regionEndX;
+	_scaleEmit(p_pif, pixel, x, y, endX - x);
+}
+
+/* First row of the block of the current row, that lies within the scaled region */
+static inline uint32_t _upscaleRow(pifHANDLE_t *p_pif)
+{
+	const uint32_t y = (uint32_t)p_pif->srcY * p_pif->scaleUp;
+	
+	return (y < p_pif->pifInfo.regionY) ? p_pif->pifInfo.regionY : y;
+}
+
+/* Repeat the current row out of the row array, up to the column last, for the other rows of the block */
+static void _upscaleRepeat(pifHANDLE_t *p_pif, uint16_t first, uint16_t last)
+{
+	const uint32_t regionEndY = (uint32_t)p_pif->pifInfo.regionY + p_pif->pifInfo.regionHeight;
+	const uint32_t * const p32_row = p_pif->pifDecoder->rowBuf;
+	uint32_t blockEndY = ((uint32_t)p_pif->srcY + 1) * p_pif->scaleUp;
+	uint16_t from, to;
+	uint32_t pixel;
+	
+	// Pixels of the same color next to each other are repeated as a single run
+	if (blockEndY > regionEndY)	blockEndY = regionEndY;
+	for (uint32_t y = _upscaleRow(p_pif) + 1; y < blockEndY; y++)
+	{
+		for (from = first; from <= last; from = to + 1)
+		{
+			pixel = p32_row[from - first];
+			for (to = from; (to < last) && (p32_row[to + 1 - first] == pixel); to++);
+			_upscaleEmit(p_pif, pixel, from, to, y);
+		}
+	}
+}
+
+/* Draw a run of pixels within a row enlarged, it is stored in the row array until the row is complete */
+static void _upscaleRun(pifHANDLE_t *p_pif, uint32_t pixel, uint16_t count)
+{
+	uint32_t * const p32_row = p_pif->pifDecoder->rowBuf;
+	uint16_t first, last, from, to;
+	
+	_sourceRange(p_pif, p_pif->pifInfo.regionX, p_pif->pifInfo.regionWidth, p_pif->srcWidth, &first, &last);
+	from = (p_pif->srcX > first) ? p_pif->srcX : first;
+	to = ((uint32_t)p_pif->srcX + count - 1 < last) ? p_pif->srcX + count - 1 : last;
+	if (from > to)	return;
+	for (uint16_t x = from; x <= to; x++)
+	{
+		p32_row[x - first] = pixel;
+	}
+	
+	_upscaleEmit(p_pif, pixel, from, to, _upscaleRow(p_pif));
+	if (to == last)	_upscaleRepeat(p_pif, first, last);
+}
+
+/* Hand a run of identical pixels of the image in the file over to the scaler, split at the row boundaries */
+static void _scaleRun(pifHANDLE_t *p_pif, uint32_t pixel, uint16_t count)
+{
+	const uint8_t shift = p_pif->scaleShift;
+	const uint16_t regionEndX = p_pif->pifInfo.regionX + p_pif->pifInfo.regionWidth;
+	uint16_t rowLeft;
+	uint32_t first, last;
+	
+	while (count && (p_pif->srcY < p_pif->srcHeight))
+	{
+		rowLeft = p_pif->srcWidth - p_pif->srcX;
+		if (rowLeft > count)	rowLeft = count;
+		
+		if (_isRowScaled(p_pif, p_pif->srcY))
+		{
+			if (p_pif->scaleUp)
+			{
+				_upscaleRun(p_pif, pixel, rowLeft);
+			}
+			else if (p_pif->scaleBytes)
+			{
+				_boxAdd(p_pif, pixel, rowLeft);
+			}
+			else
+			{
+				// Columns of the scaled image, whose top left pixel lies within the run
+				first = ((uint32_t)p_pif->srcX + (1 << shift) - 1) >> shift;
+				last = ((uint32_t)p_pif->srcX + rowLeft - 1) >> shift;
+				if (first < p_pif->pifInfo.regionX)	first = p_pif->pifInfo.regionX;
+				if (last >= regionEndX)	last = regionEndX - 1;
+				if (first <= last)	_scaleEmit(p_pif, pixel, first, p_pif->srcY >> shift, last - first + 1);
+			}
+		}
+		count -= rowLeft;
+		p_pif->srcX += rowLeft;
+		if (p_pif->srcX >= p_pif->srcWidth)
+		{
+			p_pif->srcX = 0;
+			p_pif->srcY++;
+		}
+	}
+}
+
+/* Hand a word of image data, repeated count times, over to the scaler */
+static void _scaleWord(pifHANDLE_t *p_pif, uint32_t pixelData, uint16_t repeat, const pifImageType imageType, const uint8_t bitsPerPixel)
+{
+	uint8_t index[8];
+	uint8_t pixelLimit, solidIndex;
+	
+	if (imageType <= PIF_TYPE_RGB332)
+	{
+		_scaleRun(p_pif, pixelData, repeat);
+		return;
+	}
+	
+	pixelLimit = _getSolidGroup(pixelData, bitsPerPixel, &solidIndex);
+	if (pixelLimit)
+	{
+		_scaleRun(p_pif, _getIndexedPixel(p_pif, solidIndex, imageType), (uint16_t)repeat * pixelLimit);
+		return;
+	}
+	pixelLimit = _pifUnpackGroup(pixelData, bitsPerPixel, index);
+	for (; repeat; repeat--)
+	{
+		for (uint8_t pixelCounter = 0; pixelCounter < pixelLimit; pixelCounter++)
+		{
+			_scaleRun(p_pif, _getIndexedPixel(p_pif, index[pixelCounter], imageType), 1);
+		}
+	}
+}
+
+/* Decode the image data into the reduced or enlarged image. Not specialized for the formats like
+ * _decodeImage, since it is meant for thumbnails and small icons. Works in time slices like _decodeImage,
+ * counting the pixels of the image in the file. Returns non-zero once the whole region has been decoded */
+static uint8_t _decodeScaled(pifHANDLE_t *p_PIF, uint32_t pixelBudget)
+{
+	const pifImageType imageType = p_PIF->pifInfo.imageType;
+	const uint8_t bitsPerPixel = p_PIF->pifInfo.bitsPerPixel;
+	const uint8_t filePosInc = _pifWordBytes(bitsPerPixel);
+	const uint8_t wordPixels = _pifWordPixels(bitsPerPixel);
+	uint32_t position = (uint32_t)p_PIF->srcY * p_PIF->srcWidth + p_PIF->srcX;
+	uint32_t stop = 0xFFFFFFFF;
+	uint32_t pixelData;
+	uint16_t firstRow, lastRow;
+	uint8_t done;
+	
+	_sourceRange(p_PIF, p_PIF->pifInfo.regionY, p_PIF->pifInfo.regionHeight, p_PIF->srcHeight, &firstRow, &lastRow);
+	if (pixelBudget < stop - position)	stop = position + pixelBudget;
+	
+	if (p_PIF->pifInfo.compression != PIF_COMPRESSION_NONE)
+	{
+		int16_t rleInstr = 0;
+		
+		for (; (p_PIF->pifStream.filePos < p_PIF->pifInfo.imageSize) && (p_PIF->srcY <= lastRow) &&
+			((rleInstr != 0) || ((uint32_t)p_PIF->srcY * p_PIF->srcWidth + p_PIF->srcX < stop)); p_PIF->pifStream.filePos++)
+		{
+			pixelData = _read8(&(p_PIF->pifStream));
+			if (rleInstr != 0)
+			{
+				if (bitsPerPixel > 16)
+				{
+					pixelData |= (uint32_t)_read16(&(p_PIF->pifStream)) << 8;
+					p_PIF->pifStream.filePos += 2;
+				}
+				else if (bitsPerPixel > 8)
+				{
+					pixelData |= (uint32_t)_read8(&(p_PIF->pifStream)) << 8;
+					p_PIF->pifStream.filePos++;
+				}
+			}
+			
+			if (rleInstr > 0)
+			{
+				// Runs are collapsed into the scaled columns they cover, or skipped without looking at their color
+				if (_isScaledRunHidden(p_PIF, (uint16_t)rleInstr * wordPixels))
+				{
+					_scaleSkip(p_PIF, (uint16_t)rleInstr * wordPixels);
+				}
+				else
+				{
+					_scaleWord(p_PIF, pixelData, rleInstr, imageType, bitsPerPixel);
+				}
+				rleInstr = 0;
+			}
+			else if (rleInstr < 0)
+			{
+				_scaleWord(p_PIF, pixelData, 1, imageType, bitsPerPixel);
+				rleInstr++;
+			}
+			else
+			{
+				rleInstr = _rleInstr(p_PIF, (uint8_t)pixelData);
+				
+				// Uncompressed words that aren't used are skipped without reading them
+				if ((rleInstr < 0) && _isScaledRunHidden(p_PIF, (uint16_t)(-rleInstr) * wordPixels))
+				{
+					const uint16_t literalBytes = (uint16_t)(-rleInstr) * filePosInc;
+					
+					_seek(&(p_PIF->pifStream), _tell(&(p_PIF->pifStream)) + literalBytes);
+					p_PIF->pifStream.filePos += literalBytes;
+					_scaleSkip(p_PIF, (uint16_t)(-rleInstr) * wordPixels);
+					rleInstr = 0;
+				}
+			}
+		}
+		done = (p_PIF->pifStream.filePos >= p_PIF->pifInfo.imageSize) || (p_PIF->srcY > lastRow);
+	}
+	else
+	{
+		// Only the used rows are read, nearest neighbour seeks over the other rows of every block
+		const uint8_t rowStep = (p_PIF->scaleBytes) ? 1 : (1 << p_PIF->scaleShift);
+		uint16_t firstColumn, lastColumn;
+		uint32_t y, firstWord, lastWord;
+		
+		_sourceRange(p_PIF, p_PIF->pifInfo.regionX, p_PIF->pifInfo.regionWidth, p_PIF->srcWidth, &firstColumn, &lastColumn);
+		for (y = p_PIF->nextRow; (y <= lastRow) && ((uint32_t)p_PIF->srcY * p_PIF->srcWidth + p_PIF->srcX < stop); y += rowStep)
+		{
+			// Sub-byte pixels aren't aligned to the rows, the last word of a row may already hold the next row
+			firstWord = (y * p_PIF->srcWidth + firstColumn) / wordPixels;
+			lastWord = (y * p_PIF->srcWidth + lastColumn) / wordPixels;
+			if (firstWord > p_PIF->nextWord)
+			{
+				_seek(&(p_PIF->pifStream), p_PIF->pifInfo.imageOffset + firstWord * filePosInc);
+				p_PIF->nextWord = firstWord;
+				p_PIF->srcY = (firstWord * wordPixels) / p_PIF->srcWidth;
+				p_PIF->srcX = (firstWord * wordPixels) % p_PIF->srcWidth;
+			}
+			for (; p_PIF->nextWord <= lastWord; p_PIF->nextWord++)
+			{
+				if (bitsPerPixel > 16)
+				{
+					pixelData = _read24(&(p_PIF->pifStream));
+				}
+				else if (bitsPerPixel > 8)
+				{
+					pixelData = _read16(&(p_PIF->pifStream));
+				}
+				else
+				{
+					pixelData = _read8(&(p_PIF->pifStream));
+				}
+				_scaleWord(p_PIF, pixelData, 1, imageType, bitsPerPixel);
+			}
+		}
+		p_PIF->nextRow = y;
+		done = y > lastRow;
+	}
+	
+	// The last row of blocks has no following one to push it out
+	if (done && (p_PIF->boxRow != 0xFFFF))	_boxEmit(p_PIF);
+	
+	// Image data ending before the last column of a row, repeat the pixels it did contain
+	if (done && p_PIF->scaleUp && _isRowScaled(p_PIF, p_PIF->srcY))
+	{
+		uint16_t firstColumn, lastColumn;
+		
+		_sourceRange(p_PIF, p_PIF->pifInfo.regionX, p_PIF->pifInfo.regionWidth, p_PIF->srcWidth, &firstColumn, &lastColumn);
+		if ((p_PIF->srcX > firstColumn) && (p_PIF->srcX <= lastColumn))	_upscaleRepeat(p_PIF, firstColumn, p_PIF->srcX - 1);
+	}
+	return done;
+}
+
+/* Set the drawn region to a part of the image at any position, clipped to the clipping rectangle
+ * of the painter. Returns zero if no pixel is visible */
+static uint8_t _setRegion(pifHANDLE_t *p_PIF, uint16_t srcX, uint16_t srcY, uint16_t width, uint16_t height, int32_t dstX, int32_t dstY)
+{
+	const pifPAINT_t * const p_painter = p_PIF->pifDecoder;
+	int32_t visibleX0, visibleY0, visibleX1, visibleY1;
+	
+	// Crop the region to the image, then clip its position on the display
+	if ((srcX >= p_PIF->pifInfo.imageWidth) || (srcY >= p_PIF->pifInfo.imageHeight))	return 0;
+	if (width > p_PIF->pifInfo.imageWidth - srcX)	width = p_PIF->pifInfo.imageWidth - srcX;
+	if (height > p_PIF->pifInfo.imageHeight - srcY)	height = p_PIF->pifInfo.imageHeight - srcY;
+	visibleX0 = (dstX > p_painter->clipX) ? dstX : p_painter->clipX;
+	visibleY0 = (dstY > p_painter->clipY) ? dstY : p_painter->clipY;
+	visibleX1 = ((dstX + width) < ((int32_t)p_painter->clipX + p_painter->clipWidth)) ? (dstX + width) : ((int32_t)p_painter->clipX + p_painter->clipWidth);
+	visibleY1 = ((dstY + height) < ((int32_t)p_painter->clipY + p_painter->clipHeight)) ? (dstY + height) : ((int32_t)p_painter->clipY + p_painter->clipHeight);
+	
+	if ((visibleX0 >= visibleX1) || (visibleY0 >= visibleY1))	return 0;
+	
+	p_PIF->pifInfo.regionX = srcX + (visibleX0 - dstX);
+	p_PIF->pifInfo.regionY = srcY + (visibleY0 - dstY);
+	p_PIF->pifInfo.regionWidth = visibleX1 - visibleX0;
+	p_PIF->pifInfo.regionHeight = visibleY1 - visibleY0;
+	// Display position of the image pixel 0/0, might wrap around if the image starts off-screen
+	p_PIF->pifInfo.startX = (uint16_t)(visibleX0 - p_PIF->pifInfo.regionX);
+	p_PIF->pifInfo.startY = (uint16_t)(visibleY0 - p_PIF->pifInfo.regionY);
+	return 1;
+}
+
+/* Get ready to display a part of the image at any position, clipped to the clipping rectangle of the painter.
+ * Returns PIF_RESULT_PENDING if there are pixels to decode */
+static pifRESULT _beginRegion(pifHANDLE_t *p_PIF, uint16_t srcX, uint16_t srcY, uint16_t width, uint16_t height, int32_t dstX, int32_t dstY)
+{
+	const uint8_t ColorTablePixelSize = p_PIF->pifInfo.imageType & PIF_MASK_INDEXED_COLOR_SIZE;
+	const pifPAINT_t * const p_painter = p_PIF->pifDecoder;
+	
+	// The reduced image takes the place of the image in the file, until it is drawn
+	_endScaling(p_PIF);
+	if ((p_painter->scaleDown > 1) && p_PIF->pifInfo.imageWidth && p_PIF->pifInfo.imageHeight)
+	{
+		p_PIF->scaleShift = (p_painter->scaleDown == 2) ? 1 : (p_painter->scaleDown == 4) ? 2 : 3;
+		p_PIF->scaleBytes = (p_painter->scaleFilter == PIF_SCALE_BOX) ? _displayBytes(p_PIF) : 0;
+		p_PIF->srcWidth = p_PIF->pifInfo.imageWidth;
+		p_PIF->srcHeight = p_PIF->pifInfo.imageHeight;
+		p_PIF->pifInfo.imageWidth = ((uint32_t)p_PIF->srcWidth + p_painter->scaleDown - 1) >> p_PIF->scaleShift;
+		p_PIF->pifInfo.imageHeight = ((uint32_t)p_PIF->srcHeight + p_painter->scaleDown - 1) >> p_PIF->scaleShift;
+	}
+	else if (p_painter->scaleUp > 1)
+	{
+		if (((uint32_t)p_PIF->pifInfo.imageWidth * p_painter->scaleUp > 0xFFFF) || ((uint32_t)p_PIF->pifInfo.imageHeight * p_painter->scaleUp > 0xFFFF))
+		{
+			return PIF_RESULT_DRAWERR;
+		}
+		p_PIF->scaleUp = p_painter->scaleUp;
+		p_PIF->scaleBytes = 0;
+		p_PIF->srcWidth = p_PIF->pifInfo.imageWidth;
+		p_PIF->srcHeight = p_PIF->pifInfo.imageHeight;
+		p_PIF->pifInfo.imageWidth *= p_painter->scaleUp;
+		p_PIF->pifInfo.imageHeight *= p_painter->scaleUp;
+	}
+	
+	// Nothing to draw, don't even bother the display
+	if (!_setRegion(p_PIF, srcX, srcY, width, height, dstX, dstY))
+	{
+		_endScaling(p_PIF);
+		return PIF_RESULT_OK;
+	}
+	if (p_PIF->scaleBytes && p_PIF->scaleShift)
+	{
+		if (p_painter->boxBufLen / 3 < p_PIF->pifInfo.regionWidth)
+		{
+			_endScaling(p_PIF);
+			return PIF_RESULT_DRAWERR;
+		}
+		memset(p_painter->boxBuf, 0, 3 * sizeof(uint16_t) * p_PIF->pifInfo.regionWidth);
+	}
+	if (p_PIF->scaleUp)
+	{
+		uint16_t firstColumn, lastColumn;
+		
+		_sourceRange(p_PIF, p_PIF->pifInfo.regionX, p_PIF->pifInfo.regionWidth, p_PIF->srcWidth, &firstColumn, &lastColumn);
+		if (p_painter->rowBufLen <= lastColumn - firstColumn)
+		{
+			_endScaling(p_PIF);
+			return PIF_RESULT_DRAWERR;
+		}
+	}
+	p_PIF->srcX = 0;
+	p_PIF->srcY = 0;
+	p_PIF->boxRow = 0xFFFF;
+	p_PIF->pifStream.filePos = 0;
+	p_PIF->dataError = 0;
+	
+	// If function pointer != null, call it with the image details
+	if (p_PIF->pifDecoder->prepare != NULL)
+	{
+		if (p_PIF->pifDecoder->prepare(p_PIF->pifDecoder->displayHandle, &(p_PIF->pifInfo)))
+		{
+			_endScaling(p_PIF);
+			return PIF_RESULT_DRAWERR;
+		}
+	}
+	
+	// Usually 0x1C is the image data offset address, unless a color table is in use
+	if ((p_PIF->pifInfo.imageType & PIF_MASK_INDEXED_MODE_IN_USE) && (p_PIF->pifDecoder->bypassColTable == PIF_INDEXED_NORMAL_OPERATION))
+	{		
+		// Buffer some colors from the color table, if there is any buffer available
+		// BW shares the indexed mode bit, but has no color table (color size of zero)
+		if (ColorTablePixelSize && p_PIF->pifDecoder->colTableBuf != NULL && p_PIF->pifDecoder->colTableBufLen >= ColorTablePixelSize)
+		{
+			_seek(&(p_PIF->pifStream), PIF_FORMAT_COLORTABLE_OFFSET);
+			// Allow partial buffering by only buffer the first x colors that the array can fit in
+			// Only buffer whole colors (RGB332, RGB565 or RGB888), not partially (clipping RGB888 into a 2-Byte buffer, for example)
+			const uint16_t colTableBufUsable = (p_PIF->pifDecoder->colTableBufLen / ColorTablePixelSize) * ColorTablePixelSize;
+			for (uint16_t colorByteCnt = 0; colorByteCnt < colTableBufUsable; colorByteCnt++)
+			{
+				if (colorByteCnt >= (p_PIF->pifInfo.colTableSize))
+				{
+					// No more colors to read from the color table
+					break;
+				}
+				p_PIF->pifDecoder->colTableBuf[colorByteCnt] = _read8(&(p_PIF->pifStream));
+			}
+		}
+	}
+#if PIF_COLOR_CACHE_SIZE > 0
+	memset(&(p_PIF->colCache), 0, sizeof(pifCOLORCACHE_t));
+#endif
+	
+	// Expand the palette into the LUT, if one is provided
+	p_PIF->colLutUsed = 0;
+	if ((p_PIF->pifInfo.imageType > PIF_TYPE_RGB332) && (p_PIF->pifInfo.bitsPerPixel <= 8) &&
+		(p_PIF->pifDecoder->colLut != NULL) && (p_PIF->pifDecoder->bypassColTable == PIF_INDEXED_NORMAL_OPERATION))
+	{
+		const uint16_t lutEntries = 1 << p_PIF->pifInfo.bitsPerPixel;
+		
+		p_PIF->colLutUsed = (p_PIF->pifDecoder->colLutLen < lutEntries) ? p_PIF->pifDecoder->colLutLen : lutEntries;
+		_expandPalette(p_PIF, p_PIF->pifDecoder->colLut, p_PIF->colLutUsed, p_PIF->pifDecoder->colLutFormat);
+	}
+	
+	// Seek to the right position for the image data
+	_seek(&(p_PIF->pifStream), p_PIF->pifInfo.imageOffset);
+	
+	p_PIF->pifInfo.currentX = 0;
+	p_PIF->pifInfo.currentY = 0;
+	p_PIF->spanFill = 0;
+	p_PIF->nextRow = p_PIF->pifInfo.regionY;
+	if (p_PIF->scaleShift || p_PIF->scaleUp)
+	{
+		uint16_t lastRow;
+		
+		_sourceRange(p_PIF, p_PIF->pifInfo.regionY, p_PIF->pifInfo.regionHeight, p_PIF->srcHeight, &(p_PIF->nextRow), &lastRow);
+	}
+	p_PIF->nextWord = 0;
+	return PIF_RESULT_PENDING;
+}
+
+/* Decode the next part of the image with the loop specialized for its format, finishing the image
+ * once all of it has been drawn. Returns PIF_RESULT_PENDING if there are pixels left */
+static pifRESULT _decodeStep(pifHANDLE_t *p_PIF, uint32_t pixelBudget)
+{
+	uint8_t done;
+	pifRESULT result = PIF_RESULT_OK;
+	
+	switch ((p_PIF->scaleShift | p_PIF->scaleUp) ? 0xFF : p_PIF->pifInfo.imageType)
+	{
+		case 0xFF:
+			done = _decodeScaled(p_PIF, pixelBudget);
+			break;
+#if defined(PIF_ENABLE_RGB888)
+		case PIF_TYPE_RGB888:
+			done = _decodeImage(p_PIF, PIF_TYPE_RGB888, 24, pixelBudget);
+			break;
+#endif
+#if defined(PIF_ENABLE_RGB565)
+		case PIF_TYPE_RGB565:
+			done = _decodeImage(p_PIF, PIF_TYPE_RGB565, 16, pixelBudget);
+			break;
+#endif
+#if defined(PIF_ENABLE_RGB332)
+		case PIF_TYPE_RGB332:
+			done = _decodeImage(p_PIF, PIF_TYPE_RGB332, 8, pixelBudget);
+			break;
+#endif
+#if defined(PIF_ENABLE_RGB16C)
+		case PIF_TYPE_RGB16C:
+			done = _decodeImage(p_PIF, PIF_TYPE_RGB16C, 4, pixelBudget);
+			break;
+#endif
+#if defined(PIF_ENABLE_BW)
+		case PIF_TYPE_BW:
+			done = _decodeImage(p_PIF, PIF_TYPE_BW, 1, pixelBudget);
+			break;
+#endif
+#if defined(PIF_ENABLE_IND8)
+		case PIF_TYPE_IND8:
+			done = _decodeImage(p_PIF, PIF_TYPE_IND8, p_PIF->pifInfo.bitsPerPixel, pixelBudget);
+			break;
+#endif
+#if defined(PIF_ENABLE_IND16)
+		case PIF_TYPE_IND16:
+			done = _decodeImage(p_PIF, PIF_TYPE_IND16, p_PIF->pifInfo.bitsPerPixel, pixelBudget);
+			break;
+#endif
+#if defined(PIF_ENABLE_IND24)
+		case PIF_TYPE_IND24:
+			done = _decodeImage(p_PIF, PIF_TYPE_IND24, p_PIF->pifInfo.bitsPerPixel, pixelBudget);
+			break;
+#endif
+		default:
+			return PIF_RESULT_FORMATERR;
+	}
+	
+	// Push out what's left of an incomplete row, the display should be up to date after every step
+	if (p_PIF->spanFill)	_flushSpan(p_PIF);
+	if (!done)	return PIF_RESULT_PENDING;
+	
+	// If function pointer != zero, call it
+	if (p_PIF->pifDecoder->finish != NULL)
+	{
+		if (p_PIF->pifDecoder->finish(p_PIF->pifDecoder->displayHandle, &(p_PIF->pifInfo)))	result = PIF_RESULT_DRAWERR;
+	}
+	// The display is finished with what has been decoded in front of invalid image data
+	if (p_PIF->dataError)	result = PIF_RESULT_FORMATERR;
+	_endScaling(p_PIF);
+	return result;
+}
+
+/* Display a part of the image at any position, clipped to the clipping rectangle of the painter */
+static pifRESULT _displayRegion(pifHANDLE_t *p_PIF, uint16_t srcX, uint16_t srcY, uint16_t width, uint16_t height, int32_t dstX, int32_t dstY)
+{
+	const pifRESULT result = _beginRegion(p_PIF, srcX, srcY, width, height, dstX, dstY);
+	
+	if (result != PIF_RESULT_PENDING)	return result;
+	return _decodeStep(p_PIF, 0xFFFFFFFF);
+}
+
+pifRESULT pif_display(pifHANDLE_t *p_PIF, uint16_t x0, uint16_t y0)
+{
+	// The region is cropped to the image, which may be drawn scaled
+	return _displayRegion(p_PIF, 0, 0, 0xFFFF, 0xFFFF, x0, y0);
+}
+
+pifRESULT pif_displayRegion(pifHANDLE_t *p_PIF, uint16_t srcX, uint16_t srcY, uint16_t width, uint16_t height, int16_t dstX, int16_t dstY)
+{
+	return _displayRegion(p_PIF, srcX, srcY, width, height, dstX, dstY);
+}
+
+pifRESULT pif_displayBegin(pifHANDLE_t *p_PIF, uint16_t x0, uint16_t y0)
+{
+	const pifRESULT result = _beginRegion(p_PIF, 0, 0, 0xFFFF, 0xFFFF, x0, y0);
+	
+	p_PIF->stepping = (result == PIF_RESULT_PENDING);
+	return (result == PIF_RESULT_PENDING) ? PIF_RESULT_OK : result;
+}
+
+pifRESULT pif_displayStep(pifHANDLE_t *p_PIF, uint32_t pixelBudget)
+{
+	pifRESULT result;
+	
+	// Nothing (left) to draw
+	if (!p_PIF->stepping)	return PIF_RESULT_OK;
+	
+	result = _decodeStep(p_PIF, pixelBudget);
+	if (result != PIF_RESULT_PENDING)	p_PIF->stepping = 0;
+	return result;
+}
+
+pifRESULT pif_feedStart(pifFEED_t *p_feed, const pifPAINT_t *p_painter, uint16_t x0, uint16_t y0)
+{
+	// The header parser reads the received header like an image in memory, no I/O functions needed
+	pif_createPIFHandle(&(p_feed->pifHandle), NULL, p_painter);
+	p_feed->state = PIF_FEED_HEADER;
+	p_feed->result = PIF_RESULT_OK;
+	p_feed->streamPos = 0;
+	p_feed->word = 0;
+	p_feed->wordFill = 0;
+	p_feed->rleInstr = 0;
+	p_feed->rleExtended = 0;
+	p_feed->skipBytes = 0;
+	p_feed->dstX = x0;
+	p_feed->dstY = y0;
+	
+	return ((p_painter->draw == NULL) && (p_painter->drawSpan == NULL)) ? PIF_RESULT_DRAWERR : PIF_RESULT_OK;
+}
+
+/* Parse the completely received header and get ready for the color table */
+static pifRESULT _feedHeader(pifFEED_t *p_feed)
+{
+	pifHANDLE_t * const p_PIF = &(p_feed->pifHandle);
+	const pifPAINT_t * const p_painter = p_PIF->pifDecoder;
+	uint8_t ColorTablePixelSize;
+	pifRESULT result;
+	
+	p_PIF->pifStream.memData = p_feed->header;
+	result = _openMemory(p_PIF, PIF_FORMAT_COLORTABLE_OFFSET);
+	if (result != PIF_RESULT_OK)	return result;
+	
+	// Without seeking, the image data has to follow the color table
+	if (p_PIF->pifInfo.imageOffset < (uint32_t)PIF_FORMAT_COLORTABLE_OFFSET + p_PIF->pifInfo.colTableSize)	return PIF_RESULT_FORMATERR;
+	
+	// Nothing to draw, the rest of the image is ignored without bothering the display
+	if (!_setRegion(p_PIF, 0, 0, p_PIF->pifInfo.imageWidth, p_PIF->pifInfo.imageHeight, p_feed->dstX, p_feed->dstY))
+	{
+		p_feed->state = PIF_FEED_DONE;
+		return PIF_RESULT_OK;
+	}
+	
+	// The palette LUT is filled while the color table is received, BW and RGB16C use the embedded table
+	p_PIF->colLutUsed = 0;
+	if ((p_PIF->pifInfo.imageType > PIF_TYPE_RGB332) && (p_PIF->pifInfo.bitsPerPixel <= 8) &&
+		(p_painter->colLut != NULL) && (p_painter->bypassColTable == PIF_INDEXED_NORMAL_OPERATION))
+	{
+		const uint16_t lutEntries = 1 << p_PIF->pifInfo.bitsPerPixel;
+		
+		p_PIF->colLutUsed = (p_painter->colLutLen < lutEntries) ? p_painter->colLutLen : lutEntries;
+		if ((p_PIF->pifInfo.imageType == PIF_TYPE_RGB16C) || (p_PIF->pifInfo.imageType == PIF_TYPE_BW))
+		{
+			_expandPalette(p_PIF, p_painter->colLut, p_PIF->colLutUsed, p_painter->colLutFormat);
+		}
+		else
+		{
+			memset(p_painter->colLut, 0, p_PIF->colLutUsed * sizeof(uint32_t));
+		}
+	}
+	
+	// Colors can't be read again later on, so the whole table has to fit into the buffer or the LUT
+	ColorTablePixelSize = (p_PIF->pifInfo.imageType & PIF_MASK_INDEXED_MODE_IN_USE) ? (p_PIF->pifInfo.imageType & PIF_MASK_INDEXED_COLOR_SIZE) : 0;
+	if (ColorTablePixelSize && (p_painter->bypassColTable == PIF_INDEXED_NORMAL_OPERATION) &&
+		((p_painter->colTableBuf == NULL) || (p_painter->colTableBufLen < p_PIF->pifInfo.colTableSize)) &&
+		(p_PIF->colLutUsed < (1 << p_PIF->pifInfo.bitsPerPixel)))
+	{
+		return PIF_RESULT_IOERR;
+	}
+	
+	if (p_painter->prepare != NULL)
+	{
+		if (p_painter->prepare(p_painter->displayHandle, &(p_PIF->pifInfo)))	return PIF_RESULT_DRAWERR;
+	}
+#if PIF_COLOR_CACHE_SIZE > 0
+	memset(&(p_PIF->colCache), 0, sizeof(pifCOLORCACHE_t));
+#endif
+	
+	p_PIF->pifStream.filePos = 0;
+	p_PIF->pifInfo.currentX = 0;
+	p_PIF->pifInfo.currentY = 0;
+	p_PIF->spanFill = 0;
+	p_feed->state = PIF_FEED_COLTABLE;
+	return PIF_RESULT_OK;
+}
+
+/* Store a received byte of the color table in the buffer and collect its colors for the LUT */
+static void _feedColor(pifFEED_t *p_feed, uint8_t data)
+{
+	pifHANDLE_t * const p_PIF = &(p_feed->pifHandle);
+	const pifPAINT_t * const p_painter = p_PIF->pifDecoder;
+	const uint8_t ColorTablePixelSize = p_PIF->pifInfo.imageType & PIF_MASK_INDEXED_COLOR_SIZE;
+	const uint16_t tableByte = p_feed->streamPos - PIF_FORMAT_COLORTABLE_OFFSET;
+	
+	if (!(p_PIF->pifInfo.imageType & PIF_MASK_INDEXED_MODE_IN_USE) || !ColorTablePixelSize ||
+		(p_painter->bypassColTable != PIF_INDEXED_NORMAL_OPERATION))
+	{
+		return;
+	}
+	
+	// Partially buffered colors are never looked up, as in pif_display
+	if ((p_painter->colTableBuf != NULL) && (tableByte < p_painter->colTableBufLen))	p_painter->colTableBuf[tableByte] = data;
+	
+	if (p_PIF->colLutUsed)
+	{
+		p_feed->word |= (uint32_t)data << (8 * p_feed->wordFill);
+		if (++p_feed->wordFill == ColorTablePixelSize)
+		{
+			if (tableByte / ColorTablePixelSize < p_PIF->colLutUsed)
+			{
+				p_painter->colLut[tableByte / ColorTablePixelSize] = _convertIfNeeded(p_feed->word, p_PIF->pifInfo.imageType, p_painter->colLutFormat);
+			}
+			p_feed->word = 0;
+			p_feed->wordFill = 0;
+		}
+	}
+}
+
+/* Decode received image data, works like the loops of _decodeImage but one byte after another.
+ * Stops after the last visible row and returns the amount of bytes used */
+static size_t _feedImage(pifFEED_t *p_feed, const uint8_t *p8_bytes, size_t length)
+{
+	pifHANDLE_t * const p_PIF = &(p_feed->pifHandle);
+	pifINFO_t * const p_info = &(p_PIF->pifInfo);
+	const pifImageType imageType = p_info->imageType;
+	const uint8_t bitsPerPixel = p_info->bitsPerPixel;
+	const uint8_t filePosInc = _pifWordBytes(bitsPerPixel);
+	const uint8_t wordPixels = _pifWordPixels(bitsPerPixel);
+	const uint16_t regionEndY = p_info->regionY + p_info->regionHeight;
+	uint32_t pixelData, runPixel;
+	uint8_t pixelsPerWord;
+	size_t used = 0, chunk;
+	
+	while ((used < length) && (p_PIF->pifStream.filePos < p_info->imageSize) && (p_info->currentY < regionEndY))
+	{
+		// Uncompressed words outside of the region are dropped as they arrive
+		if (p_feed->skipBytes)
+		{
+			chunk = ((length - used) < p_feed->skipBytes) ? (length - used) : p_feed->skipBytes;
+			used += chunk;
+			p_feed->skipBytes -= chunk;
+			p_PIF->pifStream.filePos += chunk;
+			continue;
+		}
+		
+		p_PIF->pifStream.filePos++;
+		if ((p_info->compression != PIF_COMPRESSION_NONE) && (p_feed->rleInstr == 0))
+		{
+			// Load the next RLE instruction. The count of an extended instruction is collected like a word
+			if (p_feed->rleExtended)
+			{
+				p_feed->word |= (uint32_t)p8_bytes[used++] << (8 * p_feed->wordFill);
+				if (++p_feed->wordFill < 2)	continue;
+				p_feed->rleInstr = _pifExtInstr((uint16_t)p_feed->word);
+				p_feed->rleExtended = 0;
+				p_feed->word = 0;
+				p_feed->wordFill = 0;
+				if (p_feed->rleInstr == 0)
+				{
+					// Invalid count, nothing behind it can be decoded
+					p_PIF->dataError = 1;
+					p_PIF->pifStream.filePos = p_info->imageSize;
+					return used;
+				}
+			}
+			else
+			{
+				p_feed->rleInstr = (int8_t)p8_bytes[used++];
+				p_feed->rleExtended = (p_feed->rleInstr == 0) && (p_info->compression == PIF_COMPRESSION_RLE_EXT);
+			}
+			if ((p_feed->rleInstr < 0) && _isRunHidden(p_info, (uint16_t)(-p_feed->rleInstr) * wordPixels))
+			{
+				p_feed->skipBytes = (uint16_t)(-p_feed->rleInstr) * filePosInc;
+				_skipPixels(p_info, (uint16_t)(-p_feed->rleInstr) * wordPixels);
+				p_feed->rleInstr = 0;
+			}
+			continue;
+		}
+		
+		// Collect the bytes of a word, which might be split between two calls
+		p_feed->word |= (uint32_t)p8_bytes[used++] << (8 * p_feed->wordFill);
+		if (++p_feed->wordFill < filePosInc)	continue;
+		pixelData = p_feed->word;
+		p_feed->word = 0;
+		p_feed->wordFill = 0;
+		
+		if (p_feed->rleInstr > 0)
+		{
+			if (_isRunHidden(p_info, (uint16_t)p_feed->rleInstr * wordPixels))
+			{
+				_skipPixels(p_info, (uint16_t)p_feed->rleInstr * wordPixels);
+				p_feed->rleInstr = 0;
+			}
+			else if ((p_PIF->pifDecoder->fillRun != NULL) && (pixelsPerWord = _getSolidWord(p_PIF, pixelData, imageType, bitsPerPixel, &runPixel)))
+			{
+				_fillRun(p_PIF, runPixel, (uint16_t)p_feed->rleInstr * pixelsPerWord);
+				p_feed->rleInstr = 0;
+			}
+			for (; p_feed->rleInstr > 0; p_feed->rleInstr--)
+			{
+				_processWord(p_PIF, pixelData, imageType, bitsPerPixel);
+			}
+		}
+		else
+		{
+			// Uncompressed word, either within a negative RLE instruction or of an uncompressed image
+			_processWord(p_PIF, pixelData, imageType, bitsPerPixel);
+			if (p_feed->rleInstr < 0)	p_feed->rleInstr++;
+		}
+	}
+	return used;
+}
+
+pifRESULT pif_feed(pifFEED_t *p_feed, const uint8_t *p8_bytes, size_t length)
+{
+	pifHANDLE_t * const p_PIF = &(p_feed->pifHandle);
+	uint32_t chunk;
+	
+	while (p_feed->state != PIF_FEED_DONE)
+	{
+		switch (p_feed->state)
+		{
+			case PIF_FEED_HEADER:
+				if (length == 0)	return PIF_RESULT_OK;
+				p_feed->header[p_feed->streamPos++] = *p8_bytes++;
+				length--;
+				if (p_feed->streamPos == PIF_FORMAT_COLORTABLE_OFFSET)
+				{
+					p_feed->result = _feedHeader(p_feed);
+					if (p_feed->result != PIF_RESULT_OK)	p_feed->state = PIF_FEED_DONE;
+				}
+				break;
+			case PIF_FEED_COLTABLE:
+				if (p_feed->streamPos >= (uint32_t)PIF_FORMAT_COLORTABLE_OFFSET + p_PIF->pifInfo.colTableSize)
+				{
+					p_feed->state = PIF_FEED_SKIP;
+					break;
+				}
+				if (length == 0)	return PIF_RESULT_OK;
+				_feedColor(p_feed, *p8_bytes++);
+				p_feed->streamPos++;
+				length--;
+				break;
+			case PIF_FEED_SKIP:
+				// Anything between the color table and the image data, like a row index, is of no use
+				if (p_feed->streamPos >= p_PIF->pifInfo.imageOffset)
+				{
+					p_feed->word = 0;
+					p_feed->wordFill = 0;
+					p_feed->state = PIF_FEED_IMAGE;
+					break;
+				}
+				if (length == 0)	return PIF_RESULT_OK;
+				chunk = p_PIF->pifInfo.imageOffset - p_feed->streamPos;
+				if (chunk > length)	chunk = length;
+				p8_bytes += chunk;
+				p_feed->streamPos += chunk;
+				length -= chunk;
+				break;
+			case PIF_FEED_IMAGE:
+				if ((p_PIF->pifStream.filePos >= p_PIF->pifInfo.imageSize) ||
+					(p_PIF->pifInfo.currentY >= p_PIF->pifInfo.regionY + p_PIF->pifInfo.regionHeight))
+				{
+					// Push out what's left of an incomplete last row
+					if (p_PIF->spanFill)	_flushSpan(p_PIF);
+					if ((p_PIF->pifDecoder->finish != NULL) && p_PIF->pifDecoder->finish(p_PIF->pifDecoder->displayHandle, &(p_PIF->pifInfo)))
+					{
+						p_feed->result = PIF_RESULT_DRAWERR;
+					}
+					if (p_PIF->dataError)	p_feed->result = PIF_RESULT_FORMATERR;
+					p_feed->state = PIF_FEED_DONE;
+					break;
+				}
+				if (length == 0)	return PIF_RESULT_OK;
+				chunk = _feedImage(p_feed, p8_bytes, length);
+				p8_bytes += chunk;
+				p_feed->streamPos += chunk;
+				length -= chunk;
+				break;
+			default:
+				break;
+		}
+	}
+	return p_feed->result;
+}
+
+/* Read a whole row into the given memory, using what's left in the read-ahead buffer first */
+static void _readRowInto(pifSTREAM_t *p_io, uint8_t *p8_dst, uint32_t rowBytes)
+{
+	uint8_t chunk;
+	
+	while (rowBytes && ((p_io->memLen != 0) || (p_io->readBufPos < p_io->readBufFill)))
+	{
+		chunk = (rowBytes > 0xFF) ? 0xFF : (uint8_t)rowBytes;
+		_readBytes(p_io, p8_dst, chunk);
+		p8_dst += chunk;
+		rowBytes -= chunk;
+	}
+	if (rowBytes)
+	{
+		_ioRead(p_io, p8_dst, rowBytes);
+		p_io->ioPos += rowBytes;
+	}
+}
+
+#if defined(PIF_SSSE3_ROW_KERNELS)
+static uint8_t rowKernelsSSSE3;		// Set once at startup if the CPU supports SSSE3
+static uint8_t rowKernelsSSE2;		// Set once at startup if the CPU supports SSE2
+
+__attribute__((constructor))
+static void _detectRowKernels(void)
+{
+	// Constructors may run before the CPU detection of the runtime itself
+	__builtin_cpu_init();
+	rowKernelsSSSE3 = __builtin_cpu_supports("ssse3") ? 1 : 0;
+	rowKernelsSSE2 = __builtin_cpu_supports("sse2") ? 1 : 0;
+}
+
+/* Look up 16 pixels at once with a 16 color palette, split into byte planes. Returns the amount
+ * of pixels processed, the remaining (less than 16) pixels are left to the scalar loop */
+__attribute__((target("ssse3")))
+static uint16_t _lookupRowSSSE3(const uint8_t *p8_index, uint8_t *p8_dst, uint16_t pixels, const uint8_t *p8_lutPlanes, uint8_t pixelBytes)
+{
+	const __m128i lutLow = _mm_loadu_si128((const __m128i *)p8_lutPlanes);
+	const __m128i lutHigh = _mm_loadu_si128((const __m128i *)(p8_lutPlanes + 16));
+	__m128i index, low, high;
+	uint16_t done;
+	
+	for (done = 0; (pixels - done) >= 16; done += 16)
+	{
+		index = _mm_loadu_si128((const __m128i *)(p8_index + done));
+		low = _mm_shuffle_epi8(lutLow, index);
+		if (pixelBytes == 1)
+		{
+			_mm_storeu_si128((__m128i *)(p8_dst + done), low);
+		}
+		else
+		{
+			high = _mm_shuffle_epi8(lutHigh, index);
+			_mm_storeu_si128((__m128i *)(p8_dst + done * 2), _mm_unpacklo_epi8(low, high));
+			_mm_storeu_si128((__m128i *)(p8_dst + done * 2 + 16), _mm_unpackhi_epi8(low, high));
+		}
+	}
+	return done;
+}
+
+/* Split 16 bytes at once into 32 indices of 4 (or 3) bit pixels. Returns the amount of pixels
+ * unpacked, the remaining (less than 32) pixels are left to the scalar loop */
+__attribute__((target("ssse3")))
+static uint16_t _unpackNibblesSSSE3(const uint8_t *p8_src, uint8_t *p8_index, uint16_t pixels, uint8_t pixelMask)
+{
+	const __m128i mask = _mm_set1_epi8((char)pixelMask);
+	__m128i packed, low, high;
+	uint16_t done;
+	
+	for (done = 0; (pixels - done) >= 32; done += 32)
+	{
+		packed = _mm_loadu_si128((const __m128i *)(p8_src + done / 2));
+		low = _mm_and_si128(packed, mask);
+		high = _mm_and_si128(_mm_srli_epi16(packed, 4), mask);
+		_mm_storeu_si128((__m128i *)(p8_index + done), _mm_unpacklo_epi8(low, high));
+		_mm_storeu_si128((__m128i *)(p8_index + done + 16), _mm_unpackhi_epi8(low, high));
+	}
+	return done;
+}
+#endif
+
+/* Look up a run of pixel indices in the expanded palette and store them in the framebuffer.
+ * p8_lutPlanes is only passed if the vectorized lookup may be used */
+static void _lookupRow(const uint8_t *p8_index, uint8_t *p8_dst, uint16_t pixels, const uint32_t *p32_lut, const uint8_t *p8_lutPlanes, uint8_t pixelBytes)
+{
+	uint16_t pixel = 0;
+	uint32_t color;
+	
+#if defined(PIF_SSSE3_ROW_KERNELS)
+	if ((p8_lutPlanes != NULL) && (pixelBytes < 3))
+	{
+		pixel = _lookupRowSSSE3(p8_index, p8_dst, pixels, p8_lutPlanes, pixelBytes);
+	}
+#else
+	(void)p8_lutPlanes;
+#endif
+	
+	switch (pixelBytes)
+	{
+		case 1:
+			for (; pixel < pixels; pixel++)
+			{
+				p8_dst[pixel] = (uint8_t)p32_lut[p8_index[pixel]];
+			}
+			break;
+		case 2:
+			for (; pixel < pixels; pixel++)
+			{
+				color = p32_lut[p8_index[pixel]];
+				p8_dst[pixel * 2] = (uint8_t)color;
+				p8_dst[pixel * 2 + 1] = (uint8_t)(color >> 8);
+			}
+			break;
+		default:
+			for (; pixel < pixels; pixel++)
+			{
+				color = p32_lut[p8_index[pixel]];
+				p8_dst[pixel * 3] = (uint8_t)color;
+				p8_dst[pixel * 3 + 1] = (uint8_t)(color >> 8);
+				p8_dst[pixel * 3 + 2] = (uint8_t)(color >> 16);
+			}
+			break;
+	}
+}
+
+/* Expand a row of packed pixel indices into the framebuffer, a few pixels at a time. The packed row may
+ * lie at the end of the destination row: Every pixel is read before its destination gets overwritten */
+static void _expandRow(const uint8_t *p8_src, uint8_t *p8_dst, uint16_t pixels, uint8_t bitsPerPixel, const uint32_t *p32_lut, uint8_t pixelBytes, uint8_t simdKernels)
+{
+	uint8_t index[PIF_ROW_KERNEL_CHUNK];
+	uint8_t lutPlanes[32];
+	const uint8_t *p8_lutPlanes = NULL;
+	uint16_t done, chunk, pixel;
+	
+	// Palettes of up to 16 colors are split into byte planes for the vectorized lookup
+	if (simdKernels && (bitsPerPixel <= 4))
+	{
+		for (pixel = 0; pixel < 16; pixel++)
+		{
+			lutPlanes[pixel] = (pixel < (1 << bitsPerPixel)) ? (uint8_t)p32_lut[pixel] : 0;
+			lutPlanes[pixel + 16] = (pixel < (1 << bitsPerPixel)) ? (uint8_t)(p32_lut[pixel] >> 8) : 0;
+		}
+		p8_lutPlanes = lutPlanes;
+	}
+	
+	for (done = 0; done < pixels; done += chunk)
+	{
+		chunk = ((pixels - done) > PIF_ROW_KERNEL_CHUNK) ? PIF_ROW_KERNEL_CHUNK : (pixels - done);
+		if (bitsPerPixel == 8)
+		{
+			memcpy(index, p8_src + done, chunk);
+		}
+		else
+		{
+			pixel = 0;
+#if defined(PIF_SSSE3_ROW_KERNELS)
+			if (simdKernels && ((bitsPerPixel == 4) || (bitsPerPixel == 3)))
+			{
+				pixel = _unpackNibblesSSSE3(p8_src, index, chunk, (bitsPerPixel == 3) ? 0x07 : 0x0F);
+				p8_src += pixel / 2;
+			}
+#endif
+			while (pixel < chunk)
+			{
+				pixel += _pifUnpackGroup(*p8_src++, bitsPerPixel, &index[pixel]);
+			}
+		}
+		_lookupRow(index, p8_dst + (size_t)done * pixelBytes, chunk, p32_lut, p8_lutPlanes, pixelBytes);
+	}
+}
+
+/* Convert a row of packed RGB pixels into the framebuffer format with pif_convertRow */
+static void _convertRowInto(const uint8_t *p8_src, uint8_t *p8_dst, uint16_t pixels, pifImageType srcFormat, pifBUFFER_t *p_buf)
+{
+	uint32_t color[PIF_ROW_KERNEL_CHUNK];
+	const uint8_t srcBytes = _formatBytes(srcFormat);
+	uint16_t chunk, pixel;
+	
+	for (; pixels; pixels -= chunk)
+	{
+		chunk = (pixels > PIF_ROW_KERNEL_CHUNK) ? PIF_ROW_KERNEL_CHUNK : pixels;
+		for (pixel = 0; pixel < chunk; pixel++, p8_src += srcBytes)
+		{
+			color[pixel] = p8_src[0];
+			if (srcBytes > 1)	color[pixel] |= (uint32_t)p8_src[1] << 8;
+			if (srcBytes > 2)	color[pixel] |= (uint32_t)p8_src[2] << 16;
+		}
+		pif_convertRow(color, color, chunk, srcFormat, p_buf->dstFormat, PIF_CONV_ACCURATE);
+		for (pixel = 0; pixel < chunk; pixel++, p8_dst += p_buf->pixelBytes)
+		{
+			p8_dst[0] = (uint8_t)color[pixel];
+			if (p_buf->pixelBytes > 1)	p8_dst[1] = (uint8_t)(color[pixel] >> 8);
+			if (p_buf->pixelBytes > 2)	p8_dst[2] = (uint8_t)(color[pixel] >> 16);
+		}
+	}
+}
+
+/* Move the framebuffer position forward by count pixels within the current row */
+static inline void _bufAdvance(pifHANDLE_t *p_pif, pifBUFFER_t *p_buf, uint16_t count)
+{
+	p_pif->pifInfo.currentX += count;
+	if (p_pif->pifInfo.currentX >= p_pif->pifInfo.imageWidth)
+	{
+		p_pif->pifInfo.currentX = 0;
+		p_pif->pifInfo.currentY++;
+		p_buf->p8_row += p_buf->stride;
+	}
+}
+
+/* Store a single pixel in the framebuffer, least significant byte first */
+static inline void _bufPixel(pifHANDLE_t *p_pif, pifBUFFER_t *p_buf, uint32_t pixel)
+{
+	uint8_t *p8_dst = p_buf->p8_row + (size_t)p_pif->pifInfo.currentX * p_buf->pixelBytes;
+	
+	// Padding bits after the last pixel of the image (or strip) are ignored
+	if (p_pif->pifInfo.currentY >= p_buf->endRow)	return;
+	
+	p8_dst[0] = (uint8_t)pixel;
+	if (p_buf->pixelBytes > 1)	p8_dst[1] = (uint8_t)(pixel >> 8);
+	if (p_buf->pixelBytes > 2)	p8_dst[2] = (uint8_t)(pixel >> 16);
+	_bufAdvance(p_pif, p_buf, 1);
+}
+
+/* Fill count pixels of the same color into the framebuffer, split at the row boundaries */
+static void _bufFill(pifHANDLE_t *p_pif, pifBUFFER_t *p_buf, uint32_t pixel, uint16_t count)
+{
+	uint8_t *p8_dst;
+	uint16_t rowLeft, done, copy;
+	
+	while (count && (p_pif->pifInfo.currentY < p_buf->endRow))
+	{
+		rowLeft = p_pif->pifInfo.imageWidth - p_pif->pifInfo.currentX;
+		if (rowLeft > count)	rowLeft = count;
+		p8_dst = p_buf->p8_row + (size_t)p_pif->pifInfo.currentX * p_buf->pixelBytes;
+		
+		if (p_buf->pixelBytes == 1)
+		{
+			memset(p8_dst, (uint8_t)pixel, rowLeft);
+		}
+		else
+		{
+			// Store the first pixel, then keep doubling the filled part
+			p8_dst[0] = (uint8_t)pixel;
+			p8_dst[1] = (uint8_t)(pixel >> 8);
+			if (p_buf->pixelBytes > 2)	p8_dst[2] = (uint8_t)(pixel >> 16);
+			for (done = 1; done < rowLeft; done += copy)
+			{
+				copy = (done < (rowLeft - done)) ? done : (rowLeft - done);
+				memcpy(p8_dst + (size_t)done * p_buf->pixelBytes, p8_dst, (size_t)copy * p_buf->pixelBytes);
+			}
+		}
+		count -= rowLeft;
+		_bufAdvance(p_pif, p_buf, rowLeft);
+	}
+}
+
+/* Store a word of image data: RGB data is converted if needed, indexed data is looked up in the expanded palette */
+static inline void _bufWord(pifHANDLE_t *p_pif, pifBUFFER_t *p_buf, uint32_t pixelData)
+{
+	if (p_buf->p32_lut == NULL)
+	{
+		_bufPixel(p_pif, p_buf, _convertIfNeeded(pixelData, p_buf->srcFormat, p_buf->dstFormat));
+		return;
+	}
+	
+	uint8_t index[8];
+	uint8_t const pixelLimit = _pifUnpackGroup(pixelData, p_pif->pifInfo.bitsPerPixel, index);
+	
+	for (uint8_t pixelCounter = 0; pixelCounter < pixelLimit; pixelCounter++)
+	{
+		_bufPixel(p_pif, p_buf, p_buf->p32_lut[index[pixelCounter]]);
+	}
+}
+
+/* Set up the framebuffer description. The whole palette of indexed images is expanded
+ * into p32_lut (256 entries) in the framebuffer format once */
+static pifRESULT _prepareBuffer(pifHANDLE_t *p_PIF, pifBUFFER_t *p_buf, void *p_dst, size_t strideBytes, pifImageType dstFormat, uint32_t *p32_lut)
+{
+	uint16_t colorCnt, lutSize;
+	
+	p_buf->p8_row = p_dst;
+	p_buf->stride = strideBytes;
+	p_buf->pixelBytes = _formatBytes(dstFormat);
+	p_buf->srcFormat = p_PIF->pifInfo.imageType;
+	p_buf->dstFormat = dstFormat;
+	p_buf->p32_lut = NULL;
+	p_buf->endRow = p_PIF->pifInfo.imageHeight;
+#if defined(PIF_SSSE3_ROW_KERNELS)
+	p_buf->simdKernels = rowKernelsSSSE3;
+#else
+	p_buf->simdKernels = 0;
+#endif
+	
+	if ((p_dst == NULL) || (p_buf->pixelBytes == 0))	return PIF_RESULT_DRAWERR;
+	
+	if (p_PIF->pifInfo.imageType > PIF_TYPE_RGB332)
+	{
+		if (p_PIF->pifInfo.bitsPerPixel == 0)	return PIF_RESULT_FORMATERR;
+		
+		// Words of more than 8 bits are looked up by their low byte, like pif_display does
+		lutSize = (p_PIF->pifInfo.bitsPerPixel > 8) ? 256 : 1 << p_PIF->pifInfo.bitsPerPixel;
+		if ((p_PIF->pifDecoder != NULL) && (p_PIF->pifDecoder->bypassColTable != PIF_INDEXED_NORMAL_OPERATION))
+		{
+			for (colorCnt = 0; colorCnt < lutSize; colorCnt++)	p32_lut[colorCnt] = colorCnt;
+		}
+		else
+		{
+			_expandPalette(p_PIF, p32_lut, lutSize, dstFormat);
+		}
+		p_buf->p32_lut = p32_lut;
+	}
+	
+	return PIF_RESULT_OK;
+}
+
+/* Store the pixels of a word from the pixel skip onwards, with the word repeated repeat times */
+static void _bufPartialWord(pifHANDLE_t *p_pif, pifBUFFER_t *p_buf, uint32_t pixelData, uint16_t skip, uint16_t repeat)
+{
+	uint8_t index[8];
+	uint8_t pixelLimit;
+	uint16_t pixel, total;
+	
+	if (p_buf->p32_lut == NULL)
+	{
+		_bufFill(p_pif, p_buf, _convertIfNeeded(pixelData, p_buf->srcFormat, p_buf->dstFormat), repeat - skip);
+		return;
+	}
+	
+	pixelLimit = _pifUnpackGroup(pixelData, p_pif->pifInfo.bitsPerPixel, index);
+	total = (uint16_t)repeat * pixelLimit;
+	for (pixel = skip; pixel < total; pixel++)
+	{
+		_bufPixel(p_pif, p_buf, p_buf->p32_lut[index[pixel % pixelLimit]]);
 	}
-	return PIF_RESULT_OK;
 }
 
-pifRESULT pif_display(pifHANDLE_t *p_PIF, uint16_t x0, uint16_t y0)
+/* Decode the rows firstRow up to (excluding) p_buf->endRow into the framebuffer. The data of firstRow
+ * starts at the entry p32_entry, laid out like the entries of pif_buildRowIndex: The file position
+ * of the RLE instruction or word holding the first pixel, and the amount of pixels in front of it.
+ * Only the rows of the strip are written, so strips can be decoded concurrently */
+static void _decodeStrip(pifHANDLE_t *p_PIF, pifBUFFER_t *p_buf, const uint32_t *p32_entry, uint16_t firstRow)
 {
-	int8_t rleInstr = 0;
+	int16_t rleInstr = 0;
 	uint32_t pixelData;
-	uint8_t seekModified = 0;
-	
-	const uint8_t ColorTablePixelSize = p_PIF->pifInfo.imageType & PIF_MASK_INDEXED_COLOR_SIZE;
-	const uint8_t filePosInc = (p_PIF->pifInfo.bitsPerPixel < 8) ? 1 : p_PIF->pifInfo.bitsPerPixel >> 3; // Division by 8
+	uint8_t pixelsPerWord, solidIndex;
+	uint16_t skip = (uint16_t)p32_entry[1];
 	
-	p_PIF->pifFileHandler->filePos = 0;
-	p_PIF->pifInfo.startX = x0;
-	p_PIF->pifInfo.startY = y0;
+	pifSTREAM_t * const p_io = &(p_PIF->pifStream);
+	const uint8_t filePosInc = _pifWordBytes(p_PIF->pifInfo.bitsPerPixel);
+	const uint8_t wordPixels = _pifWordPixels(p_PIF->pifInfo.bitsPerPixel);
+	const uint32_t rowBytes = (uint32_t)p_PIF->pifInfo.imageWidth * filePosInc;
+	uint32_t packedRowBytes = 0;
 	
-	// If function pointer != null, call it with the image details
-	if (p_PIF->pifDecoder->prepare != NULL)
+	// Row kernels need every row of indexed images to start at a byte boundary
+	if ((p_buf->p32_lut != NULL) && (((8 % p_PIF->pifInfo.bitsPerPixel) == 0) || (p_PIF->pifInfo.bitsPerPixel == 3)) &&
+		((p_PIF->pifInfo.imageWidth % wordPixels) == 0))
 	{
-		if (p_PIF->pifDecoder->prepare(p_PIF->pifDecoder->displayHandle, &(p_PIF->pifInfo)))
-		{
-			return PIF_RESULT_DRAWERR;
-		}
+		packedRowBytes = p_PIF->pifInfo.imageWidth / wordPixels;
 	}
 	
-	// Usually 0x1C is the image data offset address, unless a color table is in use
-	if ((p_PIF->pifInfo.imageType & PIF_MASK_INDEXED_MODE_IN_USE) && (p_PIF->pifDecoder->bypassColTable == PIF_INDEXED_NORMAL_OPERATION))
-	{		
-		// Buffer some colors from the color table, if there is any buffer available
-		if (p_PIF->pifDecoder->colTableBuf != NULL && p_PIF->pifDecoder->colTableBufLen >= ColorTablePixelSize)
+	_seek(p_io, p32_entry[0]);
+	p_io->filePos = p32_entry[0] - p_PIF->pifInfo.imageOffset;
+	p_PIF->pifInfo.currentX = 0;
+	p_PIF->pifInfo.currentY = firstRow;
+	p_buf->p8_row += (size_t)firstRow * p_buf->stride;
+	
+	// Pixels of the first instruction or word belonging to the rows above are dropped
+	if (skip)
+	{
+		uint16_t repeat = 1;
+		
+		if (p_PIF->pifInfo.compression != PIF_COMPRESSION_NONE)
 		{
-			// Allow partial buffering by only buffer the first x colors that the array can fit in
-			// Only buffer whole colors (RGB332, RGB565 or RGB888), not partially (clipping RGB888 into a 2-Byte buffer, for example)
-			for (uint8_t colorByteCnt = 0; (colorByteCnt + ColorTablePixelSize - 1) < p_PIF->pifDecoder->colTableBufLen; colorByteCnt++)
+			p_io->filePos++;
+			rleInstr = _rleInstr(p_PIF, _read8(p_io));
+			if (rleInstr < 0)
 			{
-				if (colorByteCnt >= (p_PIF->pifInfo.colTableSize))
-				{
-					// No more colors to read from the color table
-					break;
-				}
-				p_PIF->pifDecoder->colTableBuf[colorByteCnt] = _read8(p_PIF->pifFileHandler);
+				// Whole words are seeked over, only the word holding the first pixel is read
+				_seek(p_io, _tell(p_io) + (uint32_t)(skip / wordPixels) * filePosInc);
+				p_io->filePos += (uint32_t)(skip / wordPixels) * filePosInc;
+				rleInstr += skip / wordPixels;
+				skip %= wordPixels;
+			}
+			else
+			{
+				repeat = (uint16_t)rleInstr;
 			}
 		}
+		if (skip)
+		{
+			pixelData = (p_PIF->pifInfo.bitsPerPixel > 16) ? _read24(p_io) : (p_PIF->pifInfo.bitsPerPixel > 8) ? _read16(p_io) : _read8(p_io);
+			p_io->filePos += filePosInc;
+			_bufPartialWord(p_PIF, p_buf, pixelData, skip, repeat);
+			rleInstr = (rleInstr > 0) ? 0 : (rleInstr < 0) ? rleInstr + 1 : 0;
+		}
 	}
-	// Seek to the right position for the image data
-	p_PIF->pifFileHandler->seekPos(p_PIF->pifFileHandler->fileHandle, p_PIF->pifInfo.imageOffset);
 	
-	// Check if data is RLE-compressed
-	if (p_PIF->pifInfo.compression == PIF_COMPRESSION_RLE)
+	if (p_PIF->pifInfo.compression != PIF_COMPRESSION_NONE)
 	{
-		for (; p_PIF->pifFileHandler->filePos < p_PIF->pifInfo.imageSize; p_PIF->pifFileHandler->filePos++)
+		for (; (p_io->filePos < p_PIF->pifInfo.imageSize) && (p_PIF->pifInfo.currentY < p_buf->endRow); p_io->filePos++)
 		{
-			// Load the next byte			
-			pixelData = _read8(p_PIF->pifFileHandler);
+			pixelData = _read8(p_io);
 			
-			// Check the RLE Instruction
-			if (rleInstr > 0)
+			if (rleInstr != 0)
 			{
-				// RLE Instruction is positive: Send the pixel rleInst-amount of times
 				// Load additional bytes if RGB565 or RGB888 is used
 				if (p_PIF->pifInfo.bitsPerPixel > 16)
 				{
-					pixelData |= (uint32_t)_read16(p_PIF->pifFileHandler) << 8;
-					p_PIF->pifFileHandler->filePos += 2;
+					pixelData |= (uint32_t)_read16(p_io) << 8;
+					p_io->filePos += 2;
 				}
 				else if (p_PIF->pifInfo.bitsPerPixel > 8)
 				{
-					pixelData |= (uint32_t)_read8(p_PIF->pifFileHandler) << 8;
-					p_PIF->pifFileHandler->filePos++;
-				}
-				
-				for (; rleInstr > 0; rleInstr--)
-				{
-					
-					if (p_PIF->pifInfo.imageType <= PIF_TYPE_RGB332)
-					{
-						// raw image
-						p_PIF->pifDecoder->draw(p_PIF->pifDecoder->displayHandle, &(p_PIF->pifInfo), pixelData);
-					}
-					else
-					{
-						// indexed image
-						seekModified = _processIndexed(p_PIF, pixelData);
-					}
-					// Increase Pixel Position counter
-					p_PIF->pifInfo.currentX++;
-					if (p_PIF->pifInfo.currentX >= p_PIF->pifInfo.imageWidth)
-					{
-						p_PIF->pifInfo.currentX = 0;
-						p_PIF->pifInfo.currentY++;
-					}
+					pixelData |= (uint32_t)_read8(p_io) << 8;
+					p_io->filePos++;
 				}
 			}
-			else if (rleInstr < 0)
+			
+			if (rleInstr > 0)
 			{
-				// RLE Instruction is negative: The next (rleInst * -1)-amount of image pixels are uncompressed
-				// Load additional bytes if RGB565 or RGB888 is used
-				if (p_PIF->pifInfo.bitsPerPixel > 16)
-				{
-					pixelData |= (uint32_t)_read16(p_PIF->pifFileHandler) << 8;
-					p_PIF->pifFileHandler->filePos += 2;
-				}
-				else if (p_PIF->pifInfo.bitsPerPixel > 8)
-				{
-					pixelData |= (uint32_t)_read8(p_PIF->pifFileHandler) << 8;
-					p_PIF->pifFileHandler->filePos++;
-				}
-				if (p_PIF->pifInfo.imageType <= PIF_TYPE_RGB332)
-				{
-					// raw image
-					p_PIF->pifDecoder->draw(p_PIF->pifDecoder->displayHandle, &(p_PIF->pifInfo), pixelData);
-				}
-				else
+				// Repeated words of a single color become a fill, mixed sub-byte patterns are stored word by word
+				pixelsPerWord = (p_buf->p32_lut == NULL) ? 1 : _getSolidGroup(pixelData, p_PIF->pifInfo.bitsPerPixel, &solidIndex);
+				if (pixelsPerWord)
 				{
-					// indexed image
-					seekModified = _processIndexed(p_PIF, pixelData);
+					pixelData = (p_buf->p32_lut == NULL) ? _convertIfNeeded(pixelData, p_buf->srcFormat, p_buf->dstFormat) : p_buf->p32_lut[solidIndex];
+					_bufFill(p_PIF, p_buf, pixelData, (uint16_t)rleInstr * pixelsPerWord);
+					rleInstr = 0;
 				}
-				// Increase Pixel Position counter
-				p_PIF->pifInfo.currentX++;
-				if (p_PIF->pifInfo.currentX >= p_PIF->pifInfo.imageWidth)
+				for (; rleInstr > 0; rleInstr--)
 				{
-					p_PIF->pifInfo.currentX = 0;
-					p_PIF->pifInfo.currentY++;
+					_bufWord(p_PIF, p_buf, pixelData);
 				}
+			}
+			else if (rleInstr < 0)
+			{
+				_bufWord(p_PIF, p_buf, pixelData);
 				rleInstr++;
 			}
 			else
 			{
-				// RLE Instruction is zero / empty - load the next RLE instruction
-				rleInstr = (int8_t)pixelData;
+				rleInstr = _rleInstr(p_PIF, (uint8_t)pixelData);
 			}
-			
-			if (seekModified)
+		}
+	}
+	else if ((p_buf->p32_lut == NULL) && (_formatBytes(p_PIF->pifInfo.imageType) == p_buf->pixelBytes))
+	{
+		// Matching formats: The rows of the file are copied straight into the framebuffer
+		const uint8_t *p8_src;
+		
+		for (; p_PIF->pifInfo.currentY < p_buf->endRow; p_PIF->pifInfo.currentY++, p_buf->p8_row += p_buf->stride)
+		{
+			p8_src = _readRow(p_io, rowBytes);
+			if (p8_src != NULL)
+			{
+				memcpy(p_buf->p8_row, p8_src, rowBytes);
+			}
+			else
+			{
+				_readRowInto(p_io, p_buf->p8_row, rowBytes);
+			}
+		}
+		p_io->filePos = rowBytes * p_buf->endRow;
+	}
+	else if ((p_buf->p32_lut != NULL) && (packedRowBytes != 0))
+	{
+		// Indexed rows starting at a byte boundary are expanded row by row. Without a read-ahead
+		// buffer, the packed row is read into the end of the framebuffer row and expanded in place
+		const uint8_t *p8_src;
+		const uint32_t dstRowBytes = (uint32_t)p_PIF->pifInfo.imageWidth * p_buf->pixelBytes;
+		
+		for (; p_PIF->pifInfo.currentY < p_buf->endRow; p_PIF->pifInfo.currentY++, p_buf->p8_row += p_buf->stride)
+		{
+			p8_src = _readRow(p_io, packedRowBytes);
+			if (p8_src == NULL)
 			{
-				// If the file position has been modified by the indexed-image function, restore the index
-				p_PIF->pifFileHandler->seekPos(p_PIF->pifFileHandler->fileHandle, p_PIF->pifFileHandler->filePos + p_PIF->pifInfo.imageOffset + 1);
+				p8_src = p_buf->p8_row + dstRowBytes - packedRowBytes;
+				_readRowInto(p_io, p_buf->p8_row + dstRowBytes - packedRowBytes, packedRowBytes);
 			}
+			_expandRow(p8_src, p_buf->p8_row, p_PIF->pifInfo.imageWidth, p_PIF->pifInfo.bitsPerPixel, p_buf->p32_lut, p_buf->pixelBytes, p_buf->simdKernels);
 		}
+		p_io->filePos = packedRowBytes * p_buf->endRow;
 	}
 	else
 	{
-		for (p_PIF->pifInfo.currentY = 0; p_PIF->pifInfo.currentY < p_PIF->pifInfo.imageHeight; p_PIF->pifInfo.currentY++)
+		const uint8_t *p8_src;
+		
+		while (p_PIF->pifInfo.currentY < p_buf->endRow)
 		{
-			for (p_PIF->pifInfo.currentX = 0; p_PIF->pifInfo.currentX < p_PIF->pifInfo.imageWidth; p_PIF->pifInfo.currentX++)
+			p8_src = (p_PIF->pifInfo.bitsPerPixel >= 8) ? _readRow(p_io, rowBytes) : NULL;
+			
+			if ((p8_src != NULL) && (p_buf->p32_lut == NULL))
 			{
-				p_PIF->pifFileHandler->filePos += filePosInc;
-				if (p_PIF->pifInfo.bitsPerPixel > 16)
-				{
-					pixelData = _read24(p_PIF->pifFileHandler);
-				}
-				else if (p_PIF->pifInfo.bitsPerPixel > 8)
-				{
-					pixelData = _read16(p_PIF->pifFileHandler);
-				}
-				else
-				{
-					pixelData = _read8(p_PIF->pifFileHandler);
-				}
-								
-				if (p_PIF->pifInfo.imageType <= PIF_TYPE_RGB332)
-				{
-					// Raw RGB888 / RGB565 / RGB332 image data
-					p_PIF->pifDecoder->draw(p_PIF->pifDecoder->displayHandle, &(p_PIF->pifInfo), pixelData);
-				}
-				else
+				// RGB rows of a different format are converted a few pixels at a time
+				p_io->filePos += rowBytes;
+				_convertRowInto(p8_src, p_buf->p8_row, p_PIF->pifInfo.imageWidth, p_PIF->pifInfo.imageType, p_buf);
+				p_PIF->pifInfo.currentY++;
+				p_buf->p8_row += p_buf->stride;
+				continue;
+			}
+			if (p8_src != NULL)
+			{
+				p_io->filePos += rowBytes;
+				for (uint16_t x = 0; x < p_PIF->pifInfo.imageWidth; x++)
 				{
-					// Treat non-RGB888 / RGB565 / RGB332 image data as indexed
-					_processIndexed(p_PIF, pixelData);
+					pixelData = *p8_src++;
+					if (p_PIF->pifInfo.bitsPerPixel > 8)	pixelData |= (uint32_t)(*p8_src++) << 8;
+					if (p_PIF->pifInfo.bitsPerPixel > 16)	pixelData |= (uint32_t)(*p8_src++) << 16;
+					_bufWord(p_PIF, p_buf, pixelData);
 				}
+				continue;
+			}
+			
+			p_io->filePos += filePosInc;
+			if (p_PIF->pifInfo.bitsPerPixel > 16)
+			{
+				pixelData = _read24(p_io);
+			}
+			else if (p_PIF->pifInfo.bitsPerPixel > 8)
+			{
+				pixelData = _read16(p_io);
+			}
+			else
+			{
+				pixelData = _read8(p_io);
 			}
+			_bufWord(p_PIF, p_buf, pixelData);
 		}
-		
 	}
+}
+
+pifRESULT pif_decodeToBuffer(pifHANDLE_t *p_PIF, void *p_dst, size_t strideBytes, pifImageType dstFormat)
+{
+	pifBUFFER_t buf;
+	uint32_t lut[256];
+	const uint32_t entry[2] = {p_PIF->pifInfo.imageOffset, 0};
+	pifRESULT result = _prepareBuffer(p_PIF, &buf, p_dst, strideBytes, dstFormat, lut);
 	
-	// If function pointer != zero, call it
-	if (p_PIF->pifDecoder->finish != NULL)
+	if (result != PIF_RESULT_OK)	return result;
+	
+	p_PIF->dataError = 0;
+	_decodeStrip(p_PIF, &buf, entry, 0);
+	return (p_PIF->dataError) ? PIF_RESULT_FORMATERR : PIF_RESULT_OK;
+}
+
+/* Fill p32_offsets with the row index every everyNRows rows, without attaching it to the handle.
+ * Returns PIF_RESULT_FORMATERR if the scan ran into an invalid RLE instruction */
+static pifRESULT _scanRowIndex(pifHANDLE_t *p_PIF, uint32_t *p32_offsets, uint16_t everyNRows)
+{
+	pifSTREAM_t * const p_io = &(p_PIF->pifStream);
+	const uint8_t bitsPerPixel = p_PIF->pifInfo.bitsPerPixel;
+	const uint8_t wordBytes = _pifWordBytes(bitsPerPixel);
+	const uint8_t wordPixels = _pifWordPixels(bitsPerPixel);
+	const uint32_t entryPixels = (uint32_t)everyNRows * p_PIF->pifInfo.imageWidth;
+	uint32_t pixelPos = 0;		// First pixel of the current instruction
+	uint32_t rowPixel = 0;		// First pixel of the next row to index
+	uint32_t row = 0;
+	uint32_t entry = 0;
+	uint32_t instrPos, runPixels, payload;
+	uint8_t instrBytes;
+	int16_t rleInstr;
+	
+	if (everyNRows == p_PIF->pifInfo.fileRowIndexStep)
+	{
+		// The file already holds this index, copy it instead of scanning the image
+		for (; row < p_PIF->pifInfo.imageHeight; row += everyNRows, entry++)
+		{
+			_readFileRowIndex(p_PIF, entry, &(p32_offsets[2 * entry]));
+		}
+	}
+	else if (p_PIF->pifInfo.compression != PIF_COMPRESSION_NONE)
+	{
+		_seek(p_io, p_PIF->pifInfo.imageOffset);
+		for (instrPos = 0; (instrPos < p_PIF->pifInfo.imageSize) && (row < p_PIF->pifInfo.imageHeight); instrPos += instrBytes + payload)
+		{
+			// Only the instruction is read, the pixel data behind it is skipped
+			rleInstr = (int8_t)_read8(p_io);
+			instrBytes = 1;
+			if ((rleInstr == 0) && (p_PIF->pifInfo.compression == PIF_COMPRESSION_RLE_EXT))
+			{
+				rleInstr = _pifExtInstr(_read16(p_io));
+				instrBytes = 3;
+				if (rleInstr == 0)	return PIF_RESULT_FORMATERR;
+			}
+			runPixels = (uint32_t)((rleInstr < 0) ? -rleInstr : rleInstr) * wordPixels;
+			payload = (rleInstr < 0) ? (uint32_t)(-rleInstr) * wordBytes : (rleInstr > 0) ? wordBytes : 0;
+			
+			for (; (rowPixel < pixelPos + runPixels) && (row < p_PIF->pifInfo.imageHeight); row += everyNRows, rowPixel += entryPixels, entry++)
+			{
+				p32_offsets[2 * entry] = p_PIF->pifInfo.imageOffset + instrPos;
+				p32_offsets[2 * entry + 1] = rowPixel - pixelPos;
+			}
+			pixelPos += runPixels;
+			_seek(p_io, _tell(p_io) + payload);
+		}
+	}
+	
+	// Rows of uncompressed images are found directly, rows without data of truncated RLE images point to the end
+	for (; row < p_PIF->pifInfo.imageHeight; row += everyNRows, rowPixel += entryPixels, entry++)
+	{
+		if (p_PIF->pifInfo.compression != PIF_COMPRESSION_NONE)
+		{
+			p32_offsets[2 * entry] = p_PIF->pifInfo.imageOffset + p_PIF->pifInfo.imageSize;
+			p32_offsets[2 * entry + 1] = 0;
+		}
+		else
+		{
+			p32_offsets[2 * entry] = p_PIF->pifInfo.imageOffset + (rowPixel / wordPixels) * wordBytes;
+			p32_offsets[2 * entry + 1] = rowPixel % wordPixels;
+		}
+	}
+	return PIF_RESULT_OK;
+}
+
+pifRESULT pif_buildRowIndex(pifHANDLE_t *p_PIF, uint32_t *p32_offsets, uint16_t everyNRows)
+{
+	pifRESULT result;
+	
+	if ((p32_offsets == NULL) || (everyNRows == 0))	return PIF_RESULT_IOERR;
+	
+	result = _scanRowIndex(p_PIF, p32_offsets, everyNRows);
+	if (result != PIF_RESULT_OK)	return result;
+	p_PIF->rowIndex = p32_offsets;
+	p_PIF->rowIndexStep = everyNRows;
+	return PIF_RESULT_OK;
+}
+
+pifRESULT pif_setRowIndex(pifHANDLE_t *p_PIF, const uint32_t *p32_offsets, uint16_t everyNRows)
+{
+	if ((p32_offsets != NULL) && (everyNRows == 0))	return PIF_RESULT_IOERR;
+	
+	p_PIF->rowIndex = p32_offsets;
+	p_PIF->rowIndexStep = everyNRows;
+	return PIF_RESULT_OK;
+}
+
+#if defined(PIF_PTHREADS)
+/* A strip of rows decoded by pif_decodeParallel, with its own copy of the handle and reading position */
+typedef struct {
+	pifHANDLE_t handle;
+	pifBUFFER_t buf;
+	uint32_t entry[2];			// Row index entry of the first row
+	uint16_t firstRow;
+}pifSTRIP_t;
+
+static void *_decodeStripThread(void *p_strip)
+{
+	pifSTRIP_t *p_s = (pifSTRIP_t *)p_strip;
+	
+	_decodeStrip(&(p_s->handle), &(p_s->buf), p_s->entry, p_s->firstRow);
+	return NULL;
+}
+#endif
+
+pifRESULT pif_decodeParallel(pifHANDLE_t *p_PIF, void *p_dst, size_t strideBytes, pifImageType dstFormat, uint8_t nThreads)
+{
+#if defined(PIF_PTHREADS)
+	pifSTRIP_t strips[PIF_PARALLEL_MAX_THREADS];
+	pthread_t threads[PIF_PARALLEL_MAX_THREADS];
+	uint8_t started[PIF_PARALLEL_MAX_THREADS];
+	uint32_t offsets[2 * PIF_PARALLEL_MAX_THREADS];
+	uint32_t lut[256];
+	pifBUFFER_t buf;
+	uint32_t stripRows, endRow;
+	uint16_t indexStep;
+	uint8_t strip, stripCount;
+	pifRESULT result;
+	
+	// Every worker needs its own reading position, which only images in memory provide
+	if ((nThreads < 2) || (p_PIF->pifStream.memLen == 0) || (p_PIF->pifInfo.imageHeight < 2))
+	{
+		return pif_decodeToBuffer(p_PIF, p_dst, strideBytes, dstFormat);
+	}
+	if (nThreads > PIF_PARALLEL_MAX_THREADS)	nThreads = PIF_PARALLEL_MAX_THREADS;
+	
+	result = _prepareBuffer(p_PIF, &buf, p_dst, strideBytes, dstFormat, lut);
+	if (result != PIF_RESULT_OK)	return result;
+	
+	// Strips start at entries of the row index. Without an index fine enough,
+	// the RLE instructions are scanned once for the first row of every strip
+	stripRows = ((uint32_t)p_PIF->pifInfo.imageHeight + nThreads - 1) / nThreads;
+	indexStep = _rowIndexStep(p_PIF);
+	if ((p_PIF->pifInfo.compression != PIF_COMPRESSION_NONE) && indexStep && (indexStep <= stripRows))
+	{
+		stripRows = ((stripRows + indexStep - 1) / indexStep) * indexStep;
+		for (strip = 0; (uint32_t)strip * stripRows < p_PIF->pifInfo.imageHeight; strip++)
+		{
+			_getRowIndex(p_PIF, (uint16_t)(strip * stripRows / indexStep), &(offsets[2 * strip]));
+		}
+	}
+	else
+	{
+		result = _scanRowIndex(p_PIF, offsets, (uint16_t)stripRows);
+		if (result != PIF_RESULT_OK)	return result;
+	}
+	stripCount = (uint8_t)((p_PIF->pifInfo.imageHeight + stripRows - 1) / stripRows);
+	
+	for (strip = 0; strip < stripCount; strip++)
+	{
+		endRow = (uint32_t)(strip + 1) * stripRows;
+		strips[strip].handle = *p_PIF;
+		strips[strip].handle.dataError = 0;
+		strips[strip].buf = buf;
+		strips[strip].buf.endRow = (endRow < p_PIF->pifInfo.imageHeight) ? (uint16_t)endRow : p_PIF->pifInfo.imageHeight;
+		strips[strip].entry[0] = offsets[2 * strip];
+		strips[strip].entry[1] = offsets[2 * strip + 1];
+		strips[strip].firstRow = (uint16_t)(strip * stripRows);
+	}
+	
+	// The calling thread decodes the first strip, as well as every strip no thread could be started for
+	for (strip = 1; strip < stripCount; strip++)
+	{
+		started[strip] = (pthread_create(&(threads[strip]), NULL, _decodeStripThread, &(strips[strip])) == 0);
+	}
+	_decodeStrip(&(strips[0].handle), &(strips[0].buf), strips[0].entry, strips[0].firstRow);
+	for (strip = 1; strip < stripCount; strip++)
+	{
+		if (started[strip])
+		{
+			pthread_join(threads[strip], NULL);
+		}
+		else
+		{
+			_decodeStripThread(&(strips[strip]));
+		}
+	}
+	
+	p_PIF->pifInfo.currentX = 0;
+	p_PIF->pifInfo.currentY = p_PIF->pifInfo.imageHeight;
+	for (strip = 0; strip < stripCount; strip++)
 	{
-		if (p_PIF->pifDecoder->finish(p_PIF->pifDecoder->displayHandle, &(p_PIF->pifInfo)))	return PIF_RESULT_DRAWERR;
+		if (strips[strip].handle.dataError)	return PIF_RESULT_FORMATERR;
 	}
 	return PIF_RESULT_OK;
+#else
+	(void)nThreads;
+	return pif_decodeToBuffer(p_PIF, p_dst, strideBytes, dstFormat);
+#endif
 }
 
 pifRESULT pif_getInfo(pifHANDLE_t *p_PIF, pifINFO_t *p_Info)
@@ -573,9 +2954,14 @@ pifRESULT pif_getInfo(pifHANDLE_t *p_PIF, pifINFO_t *p_Info)
 
 pifRESULT pif_close(pifHANDLE_t *p_PIF)
 {
-	if (p_PIF->pifFileHandler->close != NULL)
+	if (p_PIF->pifStream.memLen)
+	{
+		// Nothing to close for images in memory
+		p_PIF->pifStream.memLen = 0;
+	}
+	else if (p_PIF->pifStream.fileIO->close != NULL)
 	{
-		if (p_PIF->pifFileHandler->close(p_PIF->pifFileHandler->fileHandle))
+		if (p_PIF->pifStream.fileIO->close(p_PIF->pifStream.fileHandle))
 		{
 			return PIF_RESULT_IOERR;
 		}
@@ -610,10 +2996,13 @@ pifRESULT pif_OpenAndDisplay(pifHANDLE_t *p_PIF, const char *pc_path, uint16_t x
 // green = 4*g + 3
 // blue = 8*b + 3
 // Alternatively a "fast" mode is supported, using only bitshift instructions
-uint32_t convertColor(uint32_t color, pifImageType sourceType, pifImageType targetType, pifColorConversion convMode)
+static inline uint32_t _convertPixel(uint32_t color, pifImageType sourceType, pifImageType targetType, pifColorConversion convMode)
 {
 	uint32_t outColor = 0;
 
+	// Types of the same size share the pixel format (RGB565 and IND16 for example), the pixel is kept
+	if ((_formatBytes(sourceType) != 0) && (_formatBytes(sourceType) == _formatBytes(targetType)))	return color;
+
 	switch (targetType)
 	{
 		case PIF_TYPE_RGB888:
@@ -713,4 +3102,169 @@ uint32_t convertColor(uint32_t color, pifImageType sourceType, pifImageType targ
 	}
 
 	return outColor;
-}
\ No newline at end of file
+}
+
+uint32_t convertColor(uint32_t color, pifImageType sourceType, pifImageType targetType, pifColorConversion convMode)
+{
+	return _convertPixel(color, sourceType, targetType, convMode);
+}
+
+// One loop per conversion, with constant types the compiler strips the switches out of _convertPixel
+// and is free to vectorize the loop
+#define PIF_CONVERT_ROW(sourceType, targetType, convMode)	\
+	for (; count; count--)	*p32_dst++ = _convertPixel(*p32_src++, sourceType, targetType, convMode)
+
+#if defined(PIF_SSSE3_ROW_KERNELS)
+/* A color channel of a conversion: ((color >> shift) & mask) * mul + add, stored at outShift */
+typedef struct {
+	uint8_t shift, mask, mul, add, outShift;
+}pifCHANNEL_t;
+
+/* The channels of every conversion between RGB332, RGB565 and RGB888, as done by _convertPixel.
+ * Indexed by the bytes per pixel of the source and the target minus one, and by the fast mode */
+static const pifCHANNEL_t convChannels[3][3][2][3] = {
+	{	// From RGB332
+		{{{0}}},
+		{{{5, 0x07, 4, 3, 11}, {2, 0x07, 9, 0, 5}, {0, 0x03, 10, 0, 0}},
+		 {{5, 0x07, 4, 0, 11}, {2, 0x07, 8, 0, 5}, {0, 0x03, 8, 0, 0}}},
+		{{{5, 0x07, 36, 3, 16}, {2, 0x07, 36, 3, 8}, {0, 0x03, 85, 0, 0}},
+		 {{5, 0x07, 32, 0, 16}, {2, 0x07, 32, 0, 8}, {0, 0x03, 64, 0, 0}}}
+	},
+	{	// From RGB565
+		{{{13, 0x07, 1, 0, 5}, {8, 0x07, 1, 0, 2}, {3, 0x03, 1, 0, 0}},
+		 {{13, 0x07, 1, 0, 5}, {8, 0x07, 1, 0, 2}, {3, 0x03, 1, 0, 0}}},
+		{{{0}}},
+		{{{11, 0x1F, 8, 4, 16}, {5, 0x3F, 4, 3, 8}, {0, 0x1F, 8, 3, 0}},
+		 {{11, 0x1F, 8, 0, 16}, {5, 0x3F, 4, 0, 8}, {0, 0x1F, 8, 0, 0}}}
+	},
+	{	// From RGB888
+		{{{21, 0x07, 1, 0, 5}, {13, 0x07, 1, 0, 2}, {6, 0x03, 1, 0, 0}},
+		 {{21, 0x07, 1, 0, 5}, {13, 0x07, 1, 0, 2}, {6, 0x03, 1, 0, 0}}},
+		{{{19, 0x1F, 1, 0, 11}, {10, 0x3F, 1, 0, 5}, {3, 0x1F, 1, 0, 0}},
+		 {{19, 0x1F, 1, 0, 11}, {10, 0x3F, 1, 0, 5}, {3, 0x1F, 1, 0, 0}}},
+		{{{0}}}
+	}
+};
+
+/* Convert four pixels at once with the channels given. No channel value exceeds 16 bits, even
+ * after the multiplication, so the 16 bit multiply of SSE2 works on the 32 bit pixels. Inlined
+ * with a constant conversion, the channels turn into immediate shifts and constants */
+__attribute__((target("sse2"), always_inline))
+static inline uint16_t _convertChannelsSSE2(const uint32_t *p32_src, uint32_t *p32_dst, uint16_t count, const pifCHANNEL_t *p_channels)
+{
+	const uint16_t done = count & ~3;
+	const uint32_t * const p32_end = p32_src + done;
+	__m128i color, channel, result;
+	uint8_t ch;
+	
+	for (; p32_src < p32_end; p32_src += 4, p32_dst += 4)
+	{
+		color = _mm_loadu_si128((const __m128i *)p32_src);
+		result = _mm_setzero_si128();
+		#pragma GCC unroll 3
+		for (ch = 0; ch < 3; ch++)
+		{
+			channel = _mm_and_si128(_mm_srli_epi32(color, p_channels[ch].shift), _mm_set1_epi32(p_channels[ch].mask));
+			// Multiplying by a power of two is a shift
+			if ((p_channels[ch].mul & (p_channels[ch].mul - 1)) == 0)
+			{
+				channel = _mm_slli_epi32(channel, __builtin_ctz(p_channels[ch].mul));
+			}
+			else
+			{
+				channel = _mm_mullo_epi16(channel, _mm_set1_epi32(p_channels[ch].mul));
+			}
+			if (p_channels[ch].add)	channel = _mm_add_epi32(channel, _mm_set1_epi32(p_channels[ch].add));
+			result = _mm_or_si128(result, _mm_slli_epi32(channel, p_channels[ch].outShift));
+		}
+		_mm_storeu_si128((__m128i *)p32_dst, result);
+	}
+	return done;
+}
+
+#define PIF_CONVERT_SSE2(sourceBytes, targetBytes, fast)	\
+	case (((sourceBytes) - 1) * 3 + (targetBytes) - 1) * 2 + (fast):	\
+		return _convertChannelsSSE2(p32_src, p32_dst, count, convChannels[(sourceBytes) - 1][(targetBytes) - 1][fast])
+
+/* Convert the pixels four at a time between formats of different size. Returns the amount of
+ * pixels converted, the remaining (less than 4) pixels are left to the scalar loop */
+__attribute__((target("sse2")))
+static uint16_t _convertRowSSE2(const uint32_t *p32_src, uint32_t *p32_dst, uint16_t count, uint8_t sourceBytes, uint8_t targetBytes, uint8_t fast)
+{
+	switch (((sourceBytes - 1) * 3 + targetBytes - 1) * 2 + fast)
+	{
+		PIF_CONVERT_SSE2(1, 2, 0);
+		PIF_CONVERT_SSE2(1, 2, 1);
+		PIF_CONVERT_SSE2(1, 3, 0);
+		PIF_CONVERT_SSE2(1, 3, 1);
+		PIF_CONVERT_SSE2(2, 1, 0);
+		PIF_CONVERT_SSE2(2, 1, 1);
+		PIF_CONVERT_SSE2(2, 3, 0);
+		PIF_CONVERT_SSE2(2, 3, 1);
+		PIF_CONVERT_SSE2(3, 1, 0);
+		PIF_CONVERT_SSE2(3, 1, 1);
+		PIF_CONVERT_SSE2(3, 2, 0);
+		PIF_CONVERT_SSE2(3, 2, 1);
+		default:
+			return 0;
+	}
+}
+#endif
+
+_PIF_VECTORIZE
+pifRESULT pif_convertRow(const uint32_t *p32_src, uint32_t *p32_dst, uint16_t count, pifImageType sourceType, pifImageType targetType, pifColorConversion convMode)
+{
+	const uint8_t sourceBytes = _formatBytes(sourceType);
+	const uint8_t targetBytes = _formatBytes(targetType);
+	const uint8_t fast = (convMode == PIF_CONV_FAST);
+	
+	if ((sourceBytes == 0) || (targetBytes == 0))	return PIF_RESULT_FORMATERR;
+	
+#if defined(PIF_SSSE3_ROW_KERNELS)
+	if (rowKernelsSSE2 && (sourceBytes != targetBytes))
+	{
+		const uint16_t done = _convertRowSSE2(p32_src, p32_dst, count, sourceBytes, targetBytes, fast);
+		
+		p32_src += done;
+		p32_dst += done;
+		count -= done;
+	}
+#endif
+	
+	if (sourceBytes == targetBytes)
+	{
+		if (p32_src != p32_dst)	memmove(p32_dst, p32_src, (size_t)count * sizeof(uint32_t));
+	}
+	else if (sourceBytes == 1)
+	{
+		if (targetBytes == 3)
+		{
+			if (fast)	PIF_CONVERT_ROW(PIF_TYPE_RGB332, PIF_TYPE_RGB888, PIF_CONV_FAST);
+			else		PIF_CONVERT_ROW(PIF_TYPE_RGB332, PIF_TYPE_RGB888, PIF_CONV_ACCURATE);
+		}
+		else
+		{
+			if (fast)	PIF_CONVERT_ROW(PIF_TYPE_RGB332, PIF_TYPE_RGB565, PIF_CONV_FAST);
+			else		PIF_CONVERT_ROW(PIF_TYPE_RGB332, PIF_TYPE_RGB565, PIF_CONV_ACCURATE);
+		}
+	}
+	else if (sourceBytes == 2)
+	{
+		if (targetBytes == 3)
+		{
+			if (fast)	PIF_CONVERT_ROW(PIF_TYPE_RGB565, PIF_TYPE_RGB888, PIF_CONV_FAST);
+			else		PIF_CONVERT_ROW(PIF_TYPE_RGB565, PIF_TYPE_RGB888, PIF_CONV_ACCURATE);
+		}
+		else
+		{
+			PIF_CONVERT_ROW(PIF_TYPE_RGB565, PIF_TYPE_RGB332, PIF_CONV_FAST);
+		}
+	}
+	else
+	{
+		if (targetBytes == 2)	PIF_CONVERT_ROW(PIF_TYPE_RGB888, PIF_TYPE_RGB565, PIF_CONV_FAST);
+		else					PIF_CONVERT_ROW(PIF_TYPE_RGB888, PIF_TYPE_RGB332, PIF_CONV_FAST);
+	}
+	
+	return PIF_RESULT_OK;
+}
@@ -19,9 +19,16 @@
 #include <inttypes.h>
 #include <stddef.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /** Incremental 16bit versioning number*/
 #define PIF_VERSION_NUMBER	0x0003
 
+/** Size of the image header at the start of every PIF file, all that \a pif_probe needs */
+#define PIF_HEADER_SIZE		28
+
 /** Choose to embed a RGB888 lookup table for the RGB16C colors. */
 //#define	PIF_RGB16C_RGB888
 /** Choose to embed a RGB565 lookup table for the RGB16C colors */
@@ -29,12 +36,44 @@
 /** Choose to embed a RGB332 lookup table for the RGB16C colors */
 //#define PIF_RGB16C_RGB332
 
+/** Image formats supported by the decoder. Comment out formats that are never used,
+ * to save program memory. Opening an image of a disabled format fails with PIF_RESULT_FORMATERR */
+#define PIF_ENABLE_RGB888
+#define PIF_ENABLE_RGB565
+#define PIF_ENABLE_RGB332
+#define PIF_ENABLE_RGB16C
+#define PIF_ENABLE_BW
+#define PIF_ENABLE_IND8
+#define PIF_ENABLE_IND16
+#define PIF_ENABLE_IND24
+
+/** Amount of colors of indexed images cached, that aren't covered by the color table buffer.
+ * Saves seeking to the color table for recently used colors. Set to 0 to disable the cache */
+#ifndef PIF_COLOR_CACHE_SIZE
+#define PIF_COLOR_CACHE_SIZE	8
+#endif
+
+/** Use SSSE3 for expanding indexed images in pif_decodeToBuffer and SSE2 for pif_convertRow
+ * on x86 hosts, if the CPU supports it (checked once at startup). Has no effect on other
+ * architectures */
+#define PIF_SIMD_ROW_KERNELS
+
+/** Decode strips of images in memory on several threads in pif_decodeParallel, on hosts with
+ * POSIX threads (link with -pthread). Other platforms decode on the calling thread */
+#define PIF_PARALLEL_DECODING
+
+/** Maximum amount of threads used by pif_decodeParallel */
+#ifndef PIF_PARALLEL_MAX_THREADS
+#define PIF_PARALLEL_MAX_THREADS	32
+#endif
+
 /** States wether the operation was successful or if (and what) error occured */
 typedef enum {
 	PIF_RESULT_OK,			/**< Operation was successful */
 	PIF_RESULT_IOERR,		/**< I/O File error */
 	PIF_RESULT_DRAWERR,		/**< Drawing Routines error */
-	PIF_RESULT_FORMATERR	/**< PIF File Format error */
+	PIF_RESULT_FORMATERR,	/**< PIF File Format error */
+	PIF_RESULT_PENDING		/**< Image not completely drawn yet, see \a pif_displayStep */
 }pifRESULT;
 
 /** Image Type of the .PIF image */
@@ -58,9 +97,16 @@ typedef enum {
 /** Compression type of the current open file */
 typedef enum {
 	PIF_COMPRESSION_NONE = 0,	/**< No compression */
-	PIF_COMPRESSION_RLE			/**< RLE compression */
+	PIF_COMPRESSION_RLE,		/**< RLE compression */
+	PIF_COMPRESSION_RLE_EXT		/**< RLE compression, runs and literal blocks of more than 127 words with a 16 bit count */
 }pifCompression;
 
+/** Filter used to downscale images, see \a pif_setDownscaling */
+typedef enum {
+	PIF_SCALE_NEAREST = 0,	/**< Take the top left pixel of every block */
+	PIF_SCALE_BOX = 1		/**< Average all pixels of every block */
+}pifScaleFilter;
+
 /** Operation state in indexed mode*/
 typedef enum {
 	PIF_INDEXED_NORMAL_OPERATION = 0,	/**< Normal operation */
@@ -77,11 +123,16 @@ typedef struct {
 	uint16_t imageHeight;			/**< Image Height in Pixel */
 	uint32_t imageSize;				/**< Image Data Size in Bytes */
 	uint16_t colTableSize;			/**< Color Table Size in Bytes */
-	pifCompression compression:4;	/**< RLE Compression enabled or not */
+	pifCompression compression:4;	/**< Compression of the image data */
+	uint16_t fileRowIndexStep;		/**< Rows between two entries of the row index stored in the file, 0 if there is none */
 	uint16_t startX;				/**< Display Start Positon X */
 	uint16_t startY;				/**< Display Start Position Y */
 	uint16_t currentX;				/**< Current X Positon of the image being processed */
 	uint16_t currentY;				/**< Current Y Position of the image being processed */
+	uint16_t regionX;				/**< First image column drawn, set by \a pif_displayRegion */
+	uint16_t regionY;				/**< First image row drawn, set by \a pif_displayRegion */
+	uint16_t regionWidth;			/**< Amount of image columns drawn */
+	uint16_t regionHeight;			/**< Amount of image rows drawn */
 }pifINFO_t;
 
 // Callbacks are expected to return 0. Non-zero return is treatet as an error!
@@ -108,6 +159,33 @@ typedef int8_t (PIF_PREPARE_IMAGE)(void *p_Display, pifINFO_t* p_pifInfo);
  */
 typedef void (PIF_DRAW_PIXEL)(void *p_Display, pifINFO_t* p_pifInfo, uint32_t pixel);
 
+/** 
+ * @brief Drawing callbacks: Drawing multiple pixels of a row at once
+ * 
+ * Optional replacement for \a PIF_DRAW_PIXEL, allowing the display driver to burst
+ * a whole span of pixels at once. A span never crosses the end of a row. currentX and
+ * currentY of the pifINFO_t pointer hold the position of the first pixel of the span.
+ * @param p_Display		Generic void pointer holding possible display identifiers
+ * @param p_pifInfo		pifINFO_t pointer, containing information about the current image
+ * @param p32_pixels	Color data of the pixels, in the same format as \a PIF_DRAW_PIXEL receives it
+ * @param count			Amount of pixels within the span
+ */
+typedef void (PIF_DRAW_SPAN)(void *p_Display, pifINFO_t* p_pifInfo, const uint32_t *p32_pixels, uint16_t count);
+
+/** 
+ * @brief Drawing callbacks: Filling a run of identical pixels
+ * 
+ * Optional: Called once for every RLE repeat run of a single color, instead of
+ * drawing the pixels one by one. Displays with a hardware solid-fill can use it
+ * directly. A run never crosses the end of a row. currentX and currentY of the
+ * pifINFO_t pointer hold the position of the first pixel of the run.
+ * @param p_Display		Generic void pointer holding possible display identifiers
+ * @param p_pifInfo		pifINFO_t pointer, containing information about the current image
+ * @param pixel			Color data of the run, in the same format as \a PIF_DRAW_PIXEL receives it
+ * @param count			Amount of pixels within the run
+ */
+typedef void (PIF_FILL_RUN)(void *p_Display, pifINFO_t* p_pifInfo, uint32_t pixel, uint16_t count);
+
 /** 
  * @brief Drawing callbacks: Finishing the drawing operation 
  * 
@@ -119,9 +197,29 @@ typedef void (PIF_DRAW_PIXEL)(void *p_Display, pifINFO_t* p_pifInfo, uint32_t pi
  */
 typedef int8_t (PIF_FINISH_IMAGE)(void *p_Display, pifINFO_t* p_pifInfo);
 
+#if PIF_COLOR_CACHE_SIZE > 0
+/** @brief Color cache and decode statistics
+ * 
+ * Remembers the recently used colors of indexed images that are not within the color
+ * table buffer. The counters are reset by \a pif_display, the hit rate of the cache is
+ * cacheHits / (cacheHits + cacheMisses) */
+typedef struct {
+	uint8_t index[PIF_COLOR_CACHE_SIZE];	/**< Color indices of the cached colors */
+	uint32_t color[PIF_COLOR_CACHE_SIZE];	/**< Cached colors */
+	uint8_t fill;				/**< Amount of cached colors */
+	uint8_t next;				/**< Entry to replace next */
+	uint32_t bufHits;			/**< Colors found in the color table buffer */
+	uint32_t cacheHits;			/**< Colors found in the cache */
+	uint32_t cacheMisses;		/**< Colors read from the color table in the file */
+}pifCOLORCACHE_t;
+#endif
+
 /** @brief Painting structure
  * 
- * Contains drawing function pointers, display information and optional color table buffers */
+ * Contains drawing function pointers, display information and optional color table buffers.
+ * The decoder never changes the structure itself, only the content of the arrays handed to it.
+ * A painter without arrays can be used by any amount of handles at the same time, also from
+ * different threads, a painter with arrays only by one image at a time */
 typedef struct {
 	PIF_PREPARE_IMAGE *prepare;	/**< Optional Function to allow the display operation to be prepared */
 	PIF_DRAW_PIXEL *draw;		/**< Function to draw the pixel */
@@ -131,6 +229,24 @@ typedef struct {
 								handy for displays supporting very specific formats (like 7-colors e-ink displays) */
 	uint8_t *colTableBuf;		/**< Optional array to buffer the color table */
 	uint16_t colTableBufLen;	/**< Length of the color table buffer */
+	PIF_DRAW_SPAN *drawSpan;	/**< Optional function to draw whole spans of pixels, used instead of draw if set */
+	uint32_t *spanBuf;			/**< Array to collect the pixels of a span, required by drawSpan */
+	uint16_t spanBufLen;		/**< Length of the span buffer in pixels */
+	PIF_FILL_RUN *fillRun;		/**< Optional function to fill RLE runs of a single color */
+	uint32_t *colLut;			/**< Optional array holding the whole palette, converted to colLutFormat */
+	uint16_t colLutLen;			/**< Length of the palette LUT in colors */
+	pifImageType colLutFormat;	/**< Color format the palette LUT is converted to */
+	uint16_t clipX;				/**< Left edge of the clipping rectangle on the display */
+	uint16_t clipY;				/**< Top edge of the clipping rectangle on the display */
+	uint16_t clipWidth;			/**< Width of the clipping rectangle */
+	uint16_t clipHeight;		/**< Height of the clipping rectangle */
+	uint8_t scaleDown;			/**< Images are drawn reduced by this factor (1, 2, 4 or 8) */
+	pifScaleFilter scaleFilter;	/**< Filter used to reduce the images */
+	uint16_t *boxBuf;			/**< Array holding the color sums of a row of blocks, required by PIF_SCALE_BOX */
+	uint16_t boxBufLen;			/**< Length of the box filter array */
+	uint8_t scaleUp;			/**< Images are drawn enlarged by this factor, 1 for the original size */
+	uint32_t *rowBuf;			/**< Array holding a row of the enlarged image, to repeat it without reading it again */
+	uint16_t rowBufLen;			/**< Length of the row array */
 }pifPAINT_t;
 
 // - FILE I/O FUNCTIONS REQUIRED FOR BASIC FUNCTIONALITY -
@@ -164,6 +280,18 @@ typedef int8_t (PIF_CLOSE_FILE)(void *p_fileHandle);
  */
 typedef void (PIF_READ_FILE)(void *p_fileHandle, uint8_t *p8_buf, uint8_t length);
 
+/**
+ * @brief File I/O callback: Read a block of data from file
+ * 
+ * Same as \a PIF_READ_FILE, but without the 255 bytes limit. Allows
+ * storage backends to use their multi-block transfers when the decoder
+ * reads ahead or pulls whole image rows at once.
+ * @param p_fileHandle	Void pointer to the open file
+ * @param p8_buf		Pointer to the Uint8 buffer for the data
+ * @param length		Amount of bytes to read into the buffer
+ */
+typedef void (PIF_READ_BLOCK)(void *p_fileHandle, uint8_t *p8_buf, size_t length);
+
 /**
  * @brief File I/O callback: Seek file position
  * 
@@ -174,23 +302,94 @@ typedef void (PIF_READ_FILE)(void *p_fileHandle, uint8_t *p8_buf, uint8_t length
 */
 typedef int8_t (PIF_SEEK_FILE)(void *p_fileHandle, uint32_t u32_filePos);
 
-/** File I/O structure */
+/** @brief File I/O structure
+ * 
+ * Only holds the I/O functions, the decoder never changes it. A single one can be used by any
+ * amount of handles at the same time, also from different threads if the functions allow it.
+ * Everything belonging to an opened file is kept in the \a pifSTREAM_t of the handle */
 typedef struct {
 	PIF_OPEN_FILE *open;		/**< Required function pointer to open file */
 	PIF_CLOSE_FILE *close;		/**< Optional function pointer to close the file */
-	PIF_READ_FILE *readByte;	/**< Required function pointer to read x amount of bytes */
+	PIF_READ_FILE *readByte;	/**< Function pointer to read x amount of bytes, required if readBlock isn't used */
+	PIF_READ_BLOCK *readBlock;	/**< Function pointer to read blocks of any size, preferred over readByte if set */
 	PIF_SEEK_FILE *seekPos;		/**< Required function pointer to seek / move file position */
+}pifIO_t;
+
+/** Opened file or image in memory and the reading position within it, part of every \a pifHANDLE_t */
+typedef struct {
+	const pifIO_t *fileIO;		/**< File I/O functions of the handle */
 	uint32_t filePos;			/**< File index position used internally */
 	void *fileHandle;			/**< File Handler used by the FILE I/O functions */
-}pifIO_t;
+	uint8_t *readBuf;			/**< Optional read-ahead buffer, refilled in blocks through readBlock / readByte */
+	uint16_t readBufLen;		/**< Length of the read-ahead buffer in bytes */
+	uint16_t readBufPos;		/**< Read index within the read-ahead buffer, used internally */
+	uint16_t readBufFill;		/**< Amount of valid bytes within the read-ahead buffer, used internally */
+	uint32_t ioPos;				/**< Position of the file pointer behind readByte / seekPos, used internally */
+	uint32_t ioLimit;			/**< Read-ahead is never done past this file position, used internally */
+	const uint8_t *memData;		/**< Image in RAM or memory mapped flash, set by pif_openMemory */
+	uint32_t memLen;			/**< Length of the image in memory, zero while the I/O functions are in use */
+#if defined(AVR)
+	uint32_t memFlashAddr;		/**< AVR: Far address of an image in the program memory, set by pif_openMemory_P */
+#endif
+}pifSTREAM_t;
 
-/** Final PIF Handler */
+/** @brief Final PIF Handler
+ * 
+ * Holds everything that changes while an image is opened and decoded, so images can be decoded
+ * at the same time with one handle each, sharing the \a pifIO_t and \a pifPAINT_t structures */
 typedef struct {
 	pifINFO_t pifInfo;			/**< Information about the (last) opened image */
-	pifPAINT_t *pifDecoder;		/**< Decoder to access the Display */
-	pifIO_t *pifFileHandler;	/**< File Read Functions */
+	const pifPAINT_t *pifDecoder;	/**< Decoder to access the Display */
+	pifSTREAM_t pifStream;		/**< Opened file and reading position */
+	uint16_t spanFill;			/**< Amount of pixels within the span buffer, used internally */
+	uint16_t colLutUsed;		/**< Amount of colors loaded into the palette LUT, used internally */
+#if PIF_COLOR_CACHE_SIZE > 0
+	pifCOLORCACHE_t colCache;	/**< Cache for colors past the color table buffer and decode statistics */
+#endif
+	const uint32_t *rowIndex;	/**< Optional row index of the opened image, see \a pif_buildRowIndex */
+	uint16_t rowIndexStep;		/**< Amount of rows between two entries of the row index */
+	uint8_t stepping;			/**< Set while \a pif_displayStep has an image to continue, used internally */
+	uint8_t dataError;			/**< Set once the image data turned out to be invalid while decoding, used internally */
+	uint16_t nextRow;			/**< Next row of an uncompressed image to decode, used internally */
+	uint32_t nextWord;			/**< Word of an uncompressed image at the reading position, used internally */
+	uint8_t scaleShift;			/**< Downscaling of the image being drawn as power of two, 0 if unscaled, used internally */
+	uint8_t scaleBytes;			/**< Bytes per pixel averaged by the box filter, 0 for nearest neighbour, used internally */
+	uint16_t srcWidth;			/**< Width of the image within the file while it is drawn scaled, used internally */
+	uint16_t srcHeight;			/**< Height of the image within the file while it is drawn scaled, used internally */
+	uint16_t srcX;				/**< Current x position within the image in the file while drawn scaled, used internally */
+	uint16_t srcY;				/**< Current y position within the image in the file while drawn scaled, used internally */
+	uint16_t boxRow;			/**< Row of the scaled image collected by the box filter, 0xFFFF if none, used internally */
+	uint8_t scaleUp;			/**< Enlargement of the image being drawn, 0 if not enlarged, used internally */
 }pifHANDLE_t;
 
+/** Progress of an image received through \a pif_feed */
+typedef enum {
+	PIF_FEED_HEADER,		/**< Waiting for the rest of the image header */
+	PIF_FEED_COLTABLE,		/**< Receiving the color table */
+	PIF_FEED_SKIP,			/**< Skipping the bytes between the color table and the image data */
+	PIF_FEED_IMAGE,			/**< Decoding the image data */
+	PIF_FEED_DONE			/**< Image drawn (or failed), further bytes are ignored */
+}pifFeedState;
+
+/** @brief Push-mode decoder context
+ * 
+ * Holds the whole state of an image that is received piece by piece through \a pif_feed,
+ * like from a serial interface or a DMA ring buffer. Set up with \a pif_feedStart */
+typedef struct {
+	pifHANDLE_t pifHandle;		/**< Handle of the received image, pifInfo is valid once the header is complete */
+	uint8_t header[PIF_HEADER_SIZE];	/**< Received header bytes */
+	pifFeedState state;			/**< Current state, PIF_FEED_DONE once the image has been drawn */
+	pifRESULT result;			/**< Result of the image, returned by any further call of \a pif_feed once done */
+	uint32_t streamPos;			/**< Amount of bytes of the file received so far */
+	uint32_t word;				/**< Bytes of an incomplete color or pixel word */
+	uint8_t wordFill;			/**< Amount of bytes within word */
+	int16_t rleInstr;			/**< Current RLE instruction */
+	uint8_t rleExtended;		/**< Non-zero while the count of an extended RLE instruction is received */
+	uint16_t skipBytes;			/**< Bytes of uncompressed words outside of the drawn region, which are dropped */
+	uint16_t dstX;				/**< Display x position of the image */
+	uint16_t dstY;				/**< Display y position of the image */
+}pifFEED_t;
+
 /**
  * @brief Setup the \a pifPAINT_t structure
  * 
@@ -208,6 +407,115 @@ pifRESULT pif_createPainter(pifPAINT_t *p_painter, PIF_PREPARE_IMAGE *f_optional
 		PIF_FINISH_IMAGE *f_optional_finish, void *p_displayHandler, uint8_t *p8_opt_ColTableBuf,
 		uint16_t u16_colTableBufLength);
 
+/**
+ * @brief Enable span drawing on the \a pifPAINT_t structure
+ * 
+ * Optional: Instead of calling the draw function for every pixel, the decoder collects
+ * the pixels of a row in the span buffer and hands them over in one call, once the row
+ * ends or the buffer is full. Has to be called after \a pif_createPainter, which
+ * disables span drawing. Passing NULL as function disables span drawing again.
+ * @param p_painter 			Pointer to a \a pifPAINT_t structure
+ * @param f_drawSpan 			Pointer to a \a PIF_DRAW_SPAN function
+ * @param p32_spanBuf 			Pointer to an UINT32 array to collect the pixels in
+ * @param u16_spanBufLength 	Size of the span buffer in pixels
+ * @return Returns \a pifRESULT ;PIF_RESULT_DRAWERR when f_drawSpan is passed without a buffer, otherwise PIF_RESULT_OK
+ */
+pifRESULT pif_setSpanDrawing(pifPAINT_t *p_painter, PIF_DRAW_SPAN *f_drawSpan, uint32_t *p32_spanBuf, uint16_t u16_spanBufLength);
+
+/**
+ * @brief Enable run filling on the \a pifPAINT_t structure
+ * 
+ * Optional: RLE repeat runs, whose pixels all share the same color, are handed over
+ * with a single call to the fill function, split at the row boundaries. Runs of
+ * sub-byte formats only qualify if all pixels within the repeated byte are the same.
+ * Has to be called after \a pif_createPainter, which disables run filling.
+ * Passing NULL disables run filling again.
+ * @param p_painter 			Pointer to a \a pifPAINT_t structure
+ * @param f_fillRun 			Pointer to a \a PIF_FILL_RUN function
+ * @return Returns \a pifRESULT ;always PIF_RESULT_OK
+ */
+pifRESULT pif_setRunFilling(pifPAINT_t *p_painter, PIF_FILL_RUN *f_fillRun);
+
+/**
+ * @brief Enable the palette LUT on the \a pifPAINT_t structure
+ * 
+ * Optional: Indexed images (including BW and RGB16C) get their whole palette read
+ * once at the start of \a pif_display, already converted into the given color format.
+ * Every pixel is then looked up with a single array access and the decoder never seeks
+ * back to the color table. 256 colors cover any image, smaller LUTs cover the first
+ * colors only, the remaining colors are then read and converted pixel by pixel.
+ * RGB images are not affected and still drawn in their own format. 
+ * Has to be called after \a pif_createPainter, which disables the LUT.
+ * Passing NULL disables the LUT again.
+ * @param p_painter 			Pointer to a \a pifPAINT_t structure
+ * @param p32_lut 				Pointer to an UINT32 array to hold the palette
+ * @param u16_lutLength 		Size of the LUT in colors, up to 256
+ * @param lutFormat 			Color format the display expects, PIF_TYPE_RGB888, PIF_TYPE_RGB565 or PIF_TYPE_RGB332
+ * @return Returns \a pifRESULT ;PIF_RESULT_DRAWERR for a LUT without length or an unsupported format, otherwise PIF_RESULT_OK
+ */
+pifRESULT pif_setColorLUT(pifPAINT_t *p_painter, uint32_t *p32_lut, uint16_t u16_lutLength, pifImageType lutFormat);
+
+/**
+ * @brief Set the clipping rectangle of the \a pifPAINT_t structure
+ * 
+ * Pixels outside of the rectangle are never handed to the drawing functions, neither
+ * by \a pif_display nor by \a pif_displayRegion. \a pif_createPainter sets the
+ * rectangle to cover the whole 16 bit coordinate range.
+ * @param p_painter 	Pointer to a \a pifPAINT_t structure
+ * @param x0 			Left edge of the rectangle on the display
+ * @param y0 			Top edge of the rectangle on the display
+ * @param width 		Width of the rectangle, usually the display width
+ * @param height 		Height of the rectangle, usually the display height
+ * @return Returns \a pifRESULT ;always PIF_RESULT_OK
+ */
+pifRESULT pif_setClipping(pifPAINT_t *p_painter, uint16_t x0, uint16_t y0, uint16_t width, uint16_t height);
+
+/**
+ * @brief Draw images reduced on the \a pifPAINT_t structure
+ * 
+ * \a pif_display, \a pif_displayRegion and \a pif_displayBegin draw the images reduced by the
+ * given factor, for thumbnails and previews. Every block of factor x factor pixels becomes a
+ * single pixel, the scaled image is ceil(imageWidth / factor) x ceil(imageHeight / factor)
+ * pixels large. While it is drawn, imageWidth, imageHeight and all positions in pifINFO_t refer
+ * to the scaled image (the region of \a pif_displayRegion as well), so the drawing callbacks
+ * don't need to know about it. Only the pixels of the scaled image are handed to the display:
+ * Nearest neighbour seeks over the unused rows of uncompressed images, skips the RLE runs and
+ * uncompressed words on unused rows and fills a run with a single \a PIF_FILL_RUN call.
+ * The box filter averages the pixels of every block, it needs 3 uint16_t per scaled column of
+ * the drawn region (drawing fails with PIF_RESULT_DRAWERR otherwise) and uses nearest neighbour
+ * if the color table is bypassed.
+ * \a pif_feed, \a pif_decodeToBuffer and \a pif_decodeParallel always decode the full size.
+ * @param p_painter 		Pointer to a \a pifPAINT_t structure
+ * @param factor 			Reduction factor, 1 (full size), 2, 4 or 8
+ * @param filter 			PIF_SCALE_NEAREST or PIF_SCALE_BOX
+ * @param p16_boxBuf 		Pointer to an array for the box filter, may be NULL for nearest neighbour
+ * @param u16_boxBufLength 	Length of the array in uint16_t, three times the widest scaled region
+ * @return Returns \a pifRESULT ;PIF_RESULT_DRAWERR for other factors or the box filter without an array, otherwise PIF_RESULT_OK
+ */
+pifRESULT pif_setDownscaling(pifPAINT_t *p_painter, uint8_t factor, pifScaleFilter filter, uint16_t *p16_boxBuf, uint16_t u16_boxBufLength);
+
+/**
+ * @brief Draw images enlarged on the \a pifPAINT_t structure
+ * 
+ * \a pif_display, \a pif_displayRegion and \a pif_displayBegin draw the images enlarged by an
+ * integer factor, every pixel becomes a block of factor x factor pixels. Like with
+ * \a pif_setDownscaling, imageWidth, imageHeight and all positions in pifINFO_t refer to the
+ * enlarged image while it is drawn. A pixel or RLE run is handed to \a PIF_FILL_RUN once,
+ * factor times as long, otherwise the pixels are repeated through \a PIF_DRAW_SPAN or
+ * \a PIF_DRAW_PIXEL. The pixels of every row are stored in the row array while it is drawn
+ * the first time and repeated from there for the other rows of the block, it needs one
+ * uint32_t per column of the image in the file covered by the drawn region (drawing fails with
+ * PIF_RESULT_DRAWERR otherwise, or if the enlarged image would exceed 65535 pixels).
+ * Enlarging turns downscaling off and vice versa.
+ * \a pif_feed, \a pif_decodeToBuffer and \a pif_decodeParallel always decode the original size.
+ * @param p_painter 		Pointer to a \a pifPAINT_t structure
+ * @param factor 			Enlargement factor, 1 for the original size
+ * @param p32_rowBuf 		Pointer to an array for the repeated rows, may be NULL for the factor 1
+ * @param u16_rowBufLength 	Length of the array in uint32_t, the widest image to enlarge
+ * @return Returns \a pifRESULT ;PIF_RESULT_DRAWERR for the factor 0 or enlarging without an array, otherwise PIF_RESULT_OK
+ */
+pifRESULT pif_setUpscaling(pifPAINT_t *p_painter, uint8_t factor, uint32_t *p32_rowBuf, uint16_t u16_rowBufLength);
+
 /**
  * @brief Setup the \a pifIO_t structure
  * 
@@ -223,16 +531,49 @@ pifRESULT pif_createPainter(pifPAINT_t *p_painter, PIF_PREPARE_IMAGE *f_optional
 pifRESULT pif_createIO(pifIO_t *p_fileIO, PIF_OPEN_FILE *f_openFile, PIF_CLOSE_FILE *f_closeFile,
 		PIF_READ_FILE *f_readFile, PIF_SEEK_FILE *f_seekFile);
 
+/**
+ * @brief Setup the \a pifIO_t structure with a block read function
+ * 
+ * Same as \a pif_createIO, but takes a \a PIF_READ_BLOCK function that
+ * can be asked for more than 255 bytes per call. 
+ * @param p_fileIO 		Pointer to a \a pifIO_t structure to be set up
+ * @param f_openFile 	Required pointer to a \a PIF_OPEN_FILE function
+ * @param f_closeFile 	Optional pointer to a \a PIF_CLOSE_FILE function
+ * @param f_readBlock 	Required pointer to a \a PIF_READ_BLOCK function
+ * @param f_seekFile 	Required pointer to a \a PIF_SEEK_FILE	function
+ * @return Returns \a pifRESULT ;PIF_RESULT_IOERR if any function pointer is NULL, otherwise PIF_RESULT_OK
+ */
+pifRESULT pif_createIOBlock(pifIO_t *p_fileIO, PIF_OPEN_FILE *f_openFile, PIF_CLOSE_FILE *f_closeFile,
+		PIF_READ_BLOCK *f_readBlock, PIF_SEEK_FILE *f_seekFile);
+
+/**
+ * @brief Attach a read-ahead buffer to the \a pifHANDLE_t structure
+ *
+ * Optional, but highly recommended for file systems like FatFS: Instead of calling
+ * the read function for every single pixel, the decoder fills the buffer in blocks
+ * and parses the image data straight out of it. 64 to 512 bytes are a good choice.
+ * Uncompressed images with at least 8 bits per pixel are read row by row, if
+ * the buffer can hold a whole row (imageWidth * bitsPerPixel / 8 bytes).
+ * Has to be called after \a pif_createPIFHandle, which resets the buffer. Pass NULL to
+ * disable the read-ahead buffer again. Every handle needs its own buffer.
+ * @param p_PIF 			Pointer to a \a pifHANDLE_t structure
+ * @param p8_readBuf 		Pointer to the UINT8 buffer used for reading ahead
+ * @param u16_readBufLength Size of the buffer in bytes
+ * @return Returns \a pifRESULT ;PIF_RESULT_IOERR if a buffer without length is passed, otherwise PIF_RESULT_OK
+ */
+pifRESULT pif_setReadBuffer(pifHANDLE_t *p_PIF, uint8_t *p8_readBuf, uint16_t u16_readBufLength);
+
 /**
  * @brief Setup the \a pifHANDLE_t structure
  * 
  * This optional function sets up the \a pifHANDLE_t structure by linking
  * the \a pifIO_t and \a pifPAINT_t structures to it. No checks performed. 
+ * Both structures are only read while decoding and may be shared between handles.
  * @param p_PIF 		Pointer to a \a pifHANDLE_t structure
  * @param p_fileIO		Pointer to a \a pifIO_t struture
  * @param p_painter		Pointer to a \a pifPAINT_t structure
  */
-void pif_createPIFHandle(pifHANDLE_t *p_PIF, pifIO_t *p_fileIO, pifPAINT_t *p_painter);
+void pif_createPIFHandle(pifHANDLE_t *p_PIF, const pifIO_t *p_fileIO, const pifPAINT_t *p_painter);
 
 /**
  * @brief Open & parse PIF file
@@ -246,11 +587,103 @@ void pif_createPIFHandle(pifHANDLE_t *p_PIF, pifIO_t *p_fileIO, pifPAINT_t *p_pa
  */
 pifRESULT pif_open(pifHANDLE_t *p_PIF, const char *pc_path);
 
+/**
+ * @brief Open & parse a PIF image stored in memory
+ * 
+ * Parses an image that is embedded as an array in RAM or memory mapped flash, like
+ * an exported .h file. The image data is read straight from the array: None of the
+ * I/O functions of the linked \a pifIO_t structure are called, they can be left NULL.
+ * \a pif_display and \a pif_close are used the same way as with \a pif_open.
+ * Image data reaching past length is cut off at the end of the array, imageSize of
+ * pifINFO_t is reduced accordingly and the missing pixels are decoded as zero.
+ * @param p_PIF 		Pointer to a initialized \a pifHANDLE_t structure
+ * @param p8_data 		Pointer to the PIF image in memory
+ * @param length 		Size of the PIF image in bytes
+ * @return Returns \a pifRESULT to state if the operation was successful, PIF_RESULT_FORMATERR if the
+ * image data starts beyond length, or what kind of error encountered
+ */
+pifRESULT pif_openMemory(pifHANDLE_t *p_PIF, const uint8_t *p8_data, size_t length);
+
+#if defined(AVR)
+/**
+ * @brief Open & parse a PIF image stored in the AVR program memory
+ * 
+ * Same as \a pif_openMemory, but for arrays placed in the program memory with 
+ * PROGMEM, __flash or __memx. The image is read with pgm_read_byte_far where
+ * available, so images above the first 64k of flash are supported as well.
+ * @param p_PIF 		Pointer to a initialized \a pifHANDLE_t structure
+ * @param u32_flashAddr Address of the image in the program memory, get it with pgm_get_far_address(array)
+ * @param length 		Size of the PIF image in bytes
+ * @return Returns \a pifRESULT to state if the operation was successful, or what kind of error encountered
+ */
+pifRESULT pif_openMemory_P(pifHANDLE_t *p_PIF, uint32_t u32_flashAddr, size_t length);
+#endif
+
+/**
+ * @brief Parse a PIF header that has already been read
+ * 
+ * Checks and decodes the first \a PIF_HEADER_SIZE bytes of a PIF file, without a
+ * \a pifHANDLE_t and without calling any I/O function. Meant for tools listing a
+ * large amount of images, which only read the start of every file. The same checks
+ * as in \a pif_open are applied, so an image that passes here can be opened later on
+ * (unless the file is truncated). The row index lies behind the header, fileRowIndexStep
+ * is always 0. Safe to call from any thread.
+ * @param p8_header 	The first \a PIF_HEADER_SIZE bytes of the file
+ * @param p_info 		Receives the image information, only valid if PIF_RESULT_OK is returned
+ * @return Returns PIF_RESULT_OK or PIF_RESULT_FORMATERR for anything that isn't a supported PIF image
+ */
+pifRESULT pif_probe(const uint8_t p8_header[PIF_HEADER_SIZE], pifINFO_t *p_info);
+
+/**
+ * @brief Hash of a path as stored in an image catalog
+ * 
+ * 32 bit FNV-1a over the path. ASCII letters are compared case insensitive, '\\' is
+ * treated as '/' and leading slashes are ignored, so "/ui/Logo.pif" and "ui\\logo.pif"
+ * give the same hash.
+ * @param pc_path 		Path of the image, relative to the folder the catalog was built from
+ * @return Returns the hash of the path
+ */
+uint32_t pif_catalogHash(const char *pc_path);
+
+/**
+ * @brief Look up an image in a catalog
+ * 
+ * A catalog, written by the pif_scan example with -o, holds the header of every image
+ * below a folder, sorted by the hash of its path. Finding an image takes a binary search
+ * through the catalog instead of opening the image file, so the size of all images of a
+ * user interface can be known at boot without touching the file system. The catalog is
+ * read straight from RAM or memory mapped flash. The returned information is the same
+ * as \a pif_probe would return for the header of the file.
+ * @param p8_catalog 	Pointer to the catalog in memory
+ * @param length 		Size of the catalog in bytes
+ * @param pc_path 		Path of the image, see \a pif_catalogHash
+ * @param p_info 		Receives the image information, only valid if PIF_RESULT_OK is returned
+ * @return Returns PIF_RESULT_OK, PIF_RESULT_IOERR if the image isn't in the catalog or
+ * PIF_RESULT_FORMATERR if the catalog or the image format isn't supported
+ */
+pifRESULT pif_catalogFind(const uint8_t *p8_catalog, size_t length, const char *pc_path, pifINFO_t *p_info);
+
+#if defined(AVR)
+/**
+ * @brief Look up an image in a catalog stored in the AVR program memory
+ * 
+ * Same as \a pif_catalogFind, for a catalog placed in the program memory.
+ * @param u32_flashAddr Address of the catalog in the program memory, get it with pgm_get_far_address(array)
+ * @param length 		Size of the catalog in bytes
+ * @param pc_path 		Path of the image, see \a pif_catalogHash
+ * @param p_info 		Receives the image information, only valid if PIF_RESULT_OK is returned
+ * @return Returns \a pifRESULT like \a pif_catalogFind
+ */
+pifRESULT pif_catalogFind_P(uint32_t u32_flashAddr, size_t length, const char *pc_path, pifINFO_t *p_info);
+#endif
+
 /**
  * @brief Display the PIF file
  * 
  * Reads the image data and decompresses or looks up the colors, if needed.
  * Sends the image data to show pixel by pixel to the display.
+ * An extended RLE count of zero or beyond PIF_FORMAT_RLE_EXT_MAX words ends the image data,
+ * the finish callback is still called and PIF_RESULT_FORMATERR returned.
  * @param p_PIF 		Pointer to a initialized \a pifHANDLE_t structure
  * @param x0 			Start x position of the image on the screen
  * @param y0 			Start y position of the image on the screen
@@ -258,6 +691,166 @@ pifRESULT pif_open(pifHANDLE_t *p_PIF, const char *pc_path);
  */
 pifRESULT pif_display(pifHANDLE_t *p_PIF, uint16_t x0, uint16_t y0);
 
+/**
+ * @brief Display a part of the PIF file
+ * 
+ * Same as \a pif_display, but draws only the given rectangle of the image (like a sprite
+ * out of a sheet) at the given position, which may lie partly off-screen. The rectangle is
+ * cropped to the image and clipped to the clipping rectangle of the painter. Only the visible
+ * pixels are decoded and drawn: Uncompressed images seek over the hidden rows and columns,
+ * RLE runs outside of the visible part are skipped without drawing and decoding stops after 
+ * the last visible row. RLE images with a row index, either attached by \a pif_buildRowIndex
+ * or stored in the file, start decoding at the closest indexed row above the region.
+ * currentX and currentY stay image coordinates, the visible part is
+ * described by regionX, regionY, regionWidth and regionHeight of pifINFO_t. startX and
+ * startY hold the display position of the image pixel 0/0, so startX + currentX remains the
+ * display position of a pixel (calculated with 16 bit integers, startX may wrap around).
+ * Nothing is drawn and no callback is called if no pixel is visible.
+ * @param p_PIF 		Pointer to a initialized \a pifHANDLE_t structure
+ * @param srcX 			Left edge of the rectangle within the image
+ * @param srcY 			Top edge of the rectangle within the image
+ * @param width 		Width of the rectangle
+ * @param height 		Height of the rectangle
+ * @param dstX 			Display x position of the top left pixel of the rectangle, can be negative
+ * @param dstY 			Display y position of the top left pixel of the rectangle, can be negative
+ * @return Returns \a pifRESULT to state if the operation was successful, or what kind of error encountered 
+ */
+pifRESULT pif_displayRegion(pifHANDLE_t *p_PIF, uint16_t srcX, uint16_t srcY, uint16_t width, uint16_t height, int16_t dstX, int16_t dstY);
+
+/**
+ * @brief Start displaying the PIF file in time slices
+ * 
+ * Does everything \a pif_display does before decoding the image data (calling prepare,
+ * buffering the color table), then returns. The image is drawn by calling \a pif_displayStep
+ * until it stops returning PIF_RESULT_PENDING, for example once per tick of a scheduler task.
+ * Neither the handle nor its painter or I/O structure may be used for anything else meanwhile.
+ * @param p_PIF 		Pointer to a initialized \a pifHANDLE_t structure with an opened image
+ * @param x0 			Start x position of the image on the screen
+ * @param y0 			Start y position of the image on the screen
+ * @return Returns \a pifRESULT to state if the operation was successful, or what kind of error encountered 
+ */
+pifRESULT pif_displayBegin(pifHANDLE_t *p_PIF, uint16_t x0, uint16_t y0);
+
+/**
+ * @brief Draw the next part of the image started by \a pif_displayBegin
+ * 
+ * Decodes about pixelBudget pixels of the image and returns, keeping the position within the
+ * handle. Uncompressed images are decoded in whole rows of the drawn region, RLE images in whole
+ * RLE instructions, so a step may exceed the budget by one instruction: 127 words, or
+ * PIF_FORMAT_RLE_EXT_MAX words with extended RLE, times the pixels per word (up to 8).
+ * Pixels collected for \a PIF_DRAW_SPAN are pushed out at the end of every step. Once the
+ * last pixel has been drawn, the finish callback is called.
+ * @param p_PIF 		Pointer to the \a pifHANDLE_t structure passed to \a pif_displayBegin
+ * @param pixelBudget 	Amount of image pixels to decode at most (roughly) within this step
+ * @return Returns PIF_RESULT_PENDING while the image isn't completely drawn, afterwards like \a pif_display
+ */
+pifRESULT pif_displayStep(pifHANDLE_t *p_PIF, uint32_t pixelBudget);
+
+/**
+ * @brief Start receiving an image in push-mode
+ * 
+ * Prepares a \a pifFEED_t context to draw an image, whose bytes are passed to \a pif_feed as
+ * they arrive. No I/O structure is needed, the image is never seeked and never stored.
+ * @param p_feed 		Pointer to the \a pifFEED_t context to set up
+ * @param p_painter 	Pointer to the \a pifPAINT_t structure to draw the image with
+ * @param x0 			Start x position of the image on the screen
+ * @param y0 			Start y position of the image on the screen
+ * @return Returns \a pifRESULT ;PIF_RESULT_DRAWERR if the painter has no drawing function, otherwise PIF_RESULT_OK
+ */
+pifRESULT pif_feedStart(pifFEED_t *p_feed, const pifPAINT_t *p_painter, uint16_t x0, uint16_t y0);
+
+/**
+ * @brief Decode the next received bytes of an image
+ * 
+ * Pass the file in pieces of any size, starting with the first byte of the header. Pixels
+ * are drawn as soon as their bytes arrived, the context keeps the state in between (header,
+ * color table, RLE instruction and incomplete words). Draws like \a pif_display, including
+ * clipping, span drawing, run filling and the palette LUT. The prepare callback is called once
+ * the header is complete, the finish callback after the last visible row. state becomes
+ * PIF_FEED_DONE then, any further bytes (like the rest of the file) are ignored.
+ * Since the color table can't be read again, it has to fit into the color table buffer or
+ * the palette LUT of the painter (or the table is bypassed), otherwise PIF_RESULT_IOERR is
+ * returned once the header is complete. Invalid image data finishes the image like in
+ * \a pif_display, with PIF_RESULT_FORMATERR as result.
+ * @param p_feed 		Pointer to a \a pifFEED_t context set up by \a pif_feedStart
+ * @param p8_bytes 		Pointer to the received bytes
+ * @param length 		Amount of received bytes
+ * @return Returns \a pifRESULT to state if the image is fine so far, or what kind of error encountered
+ */
+pifRESULT pif_feed(pifFEED_t *p_feed, const uint8_t *p8_bytes, size_t length);
+
+/**
+ * @brief Decode the PIF file into a framebuffer
+ * 
+ * Decodes the whole image straight into a caller-supplied framebuffer, without calling
+ * any drawing callbacks. Pixels are stored with 1, 2 or 3 bytes each (RGB332, RGB565 or 
+ * RGB888), least significant byte first like in the PIF file. Matching formats are copied
+ * row by row, RLE runs are filled and indexed images are looked up in a palette that is
+ * converted into the framebuffer format once (needs about 1kB of stack). Indices of more
+ * than 8 bits are looked up by their low byte, as in \a pif_display. Other formats are
+ * converted with \a convertColor in accurate mode. Bypassing the color table stores the
+ * raw index values instead. The \a pifPAINT_t structure of the handle may be NULL.
+ * @param p_PIF 		Pointer to a initialized \a pifHANDLE_t structure with an opened image
+ * @param p_dst 		Pointer to the first pixel of the image in the framebuffer
+ * @param strideBytes 	Distance between the start of two rows in the framebuffer in bytes
+ * @param dstFormat 	Pixel format of the framebuffer, PIF_TYPE_RGB888, PIF_TYPE_RGB565 or PIF_TYPE_RGB332
+ * @return Returns \a pifRESULT ;PIF_RESULT_DRAWERR for an unsupported framebuffer format, otherwise like \a pif_display
+ */
+pifRESULT pif_decodeToBuffer(pifHANDLE_t *p_PIF, void *p_dst, size_t strideBytes, pifImageType dstFormat);
+
+/**
+ * @brief Decode the opened image into a framebuffer on several threads
+ * 
+ * Same as \a pif_decodeToBuffer, but the image is split into strips of rows, which are
+ * decoded concurrently into their own part of the framebuffer. RLE strips start at an entry
+ * of the row index in use (attached by \a pif_buildRowIndex or stored in the file); if there
+ * is none or it is too coarse, the RLE instructions are scanned once for the first row of
+ * every strip. The calling thread decodes a strip as well and returns once all are done.
+ * Only images opened with \a pif_openMemory are split, as every
+ * thread needs its own reading position. Other images, nThreads below 2 or builds without
+ * PIF_PARALLEL_DECODING and POSIX threads fall back to \a pif_decodeToBuffer.
+ * @param p_PIF 		Pointer to a initialized \a pifHANDLE_t structure with an opened image
+ * @param p_dst 		Pointer to the first pixel of the image in the framebuffer
+ * @param strideBytes 	Distance between the start of two rows in the framebuffer in bytes
+ * @param dstFormat 	Pixel format of the framebuffer, PIF_TYPE_RGB888, PIF_TYPE_RGB565 or PIF_TYPE_RGB332
+ * @param nThreads 		Amount of threads to decode with, including the calling one, up to PIF_PARALLEL_MAX_THREADS
+ * @return Returns \a pifRESULT ;like \a pif_decodeToBuffer
+ */
+pifRESULT pif_decodeParallel(pifHANDLE_t *p_PIF, void *p_dst, size_t strideBytes, pifImageType dstFormat, uint8_t nThreads);
+
+/**
+ * @brief Build a row index of the opened image
+ * 
+ * Walks through the image data once, reading only the RLE instructions and seeking over
+ * the pixel data, which is far cheaper than decoding the image. For every everyNRows-th
+ * row, two words are stored: The file position of the RLE instruction holding the first
+ * pixel of the row, followed by the amount of pixels of that instruction belonging to the
+ * rows above. Uncompressed images get the position of the word holding the first pixel
+ * and the amount of pixels in front of it within the word.
+ * The index is attached to the handle, so \a pif_displayRegion starts decoding RLE images
+ * at the closest indexed row instead of the start of the image. It stays valid for the
+ * image and may be cached by the application, see \a pif_setRowIndex.
+ * If the file already holds a row index with the same everyNRows, it is copied instead.
+ * @param p_PIF 		Pointer to a initialized \a pifHANDLE_t structure with an opened image
+ * @param p32_offsets 	Array for the index, 2 * ((imageHeight + everyNRows - 1) / everyNRows) words long
+ * @param everyNRows 	Amount of rows between two entries of the index, 1 indexes every row
+ * @return Returns \a pifRESULT ;PIF_RESULT_IOERR without array or everyNRows, PIF_RESULT_FORMATERR
+ * for an invalid RLE instruction (the index isn't attached then), otherwise PIF_RESULT_OK
+ */
+pifRESULT pif_buildRowIndex(pifHANDLE_t *p_PIF, uint32_t *p32_offsets, uint16_t everyNRows);
+
+/**
+ * @brief Attach a row index to the handle
+ * 
+ * Attaches a previously built (and cached) row index of the opened image to the handle.
+ * Opening an image detaches the index, pass NULL to detach it manually.
+ * @param p_PIF 		Pointer to a initialized \a pifHANDLE_t structure with an opened image
+ * @param p32_offsets 	Row index built by \a pif_buildRowIndex for this image
+ * @param everyNRows 	Amount of rows between two entries, as passed to \a pif_buildRowIndex
+ * @return Returns \a pifRESULT ;PIF_RESULT_IOERR if an index without everyNRows is passed, otherwise PIF_RESULT_OK
+ */
+pifRESULT pif_setRowIndex(pifHANDLE_t *p_PIF, const uint32_t *p32_offsets, uint16_t everyNRows);
+
 /**
  * @brief Get PIF image information
  * 
@@ -297,7 +890,9 @@ pifRESULT pif_OpenAndDisplay(pifHANDLE_t *p_PIF, const char *pc_path, uint16_t x
  * Convert the pixel image data from one type to the other type as accurate as possible
  * If possible, use images supported natively by the display - this is a helper function
  * to provide image support for any display type. Setting convMode to 1 enables a faster
- * conversion method at the cost of color accuracy.
+ * conversion method at the cost of color accuracy. Types with the same pixel size (RGB565
+ * and IND16 for example) share the format, the pixel is returned unchanged. BW and RGB16C
+ * can't be converted and return 0.
  * @param color 		The pixel to convert
  * @param sourceType 	The \a pifImageType source type of the pixel
  * @param targetType 	The \a pifImageType target to convert to
@@ -306,4 +901,28 @@ pifRESULT pif_OpenAndDisplay(pifHANDLE_t *p_PIF, const char *pc_path, uint16_t x
  */
 uint32_t convertColor(uint32_t color, pifImageType sourceType, pifImageType targetType, pifColorConversion convMode);
 
+/**
+ * @brief Convert a row of pixels
+ * 
+ * Converts a whole array of pixels from one type to the other, like \a convertColor does
+ * for a single pixel, but with one specialized loop per conversion instead of looking at
+ * the types for every pixel. Can be used on the pixels passed to \a PIF_DRAW_SPAN.
+ * Converts four pixels at a time with SSE2 (see PIF_SIMD_ROW_KERNELS), GCC vectorizes the
+ * loops for other targets like NEON on ARM as well.
+ * Converting in place (p32_src equal to p32_dst) is allowed, pixels of types with the
+ * same size are copied unchanged, just as \a convertColor returns them.
+ * @param p32_src 		Pointer to the pixels to convert
+ * @param p32_dst 		Pointer to the array to store the converted pixels in
+ * @param count 		Amount of pixels to convert
+ * @param sourceType 	The \a pifImageType source type of the pixels
+ * @param targetType 	The \a pifImageType target to convert to
+ * @param convMode 		Selects which color conversion should be applied
+ * @return Returns \a pifRESULT ;PIF_RESULT_FORMATERR if BW or RGB16C is passed as type, otherwise PIF_RESULT_OK
+ */
+pifRESULT pif_convertRow(const uint32_t *p32_src, uint32_t *p32_dst, uint16_t count, pifImageType sourceType, pifImageType targetType, pifColorConversion convMode);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* PIFDEC_H_ */
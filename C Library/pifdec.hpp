@@ -0,0 +1,430 @@
+/**
+ * @file pifdec.hpp
+ *
+ * @brief PIF Decoder Library, header-only C++17 variant
+ * Copyright (c) 2022 gfcwfzkm ( gfcwfzkm@protonmail.com )
+ * License: GNU Lesser General Public License, Version 2.1
+ * 		http://www.gnu.org/licenses/lgpl-2.1.html
+ *
+ * The image source and the display are template parameters instead of function
+ * pointers, so the compiler can inline the whole decoding loop down to the single
+ * bytes read and pixels drawn. Uses the types and configuration of pifdec.h and
+ * reads the header, the color tables and the image data through the format
+ * definitions of pifdec_format.h shared with pifdec.c, so it decodes the images
+ * exactly like \a pif_display does (same pixels, same order, same pifINFO_t
+ * positions), without requiring pifdec.c.
+ *
+ * A Source has to provide:
+ * @code
+ * uint8_t read8();								// Next byte, 0 if there's no data left
+ * void seek(uint32_t u32_filePos);				// Move to the absolute file position
+ * @endcode
+ * A Sink has to provide the same functions as the \a pifPAINT_t callbacks:
+ * @code
+ * int8_t prepare(pifINFO_t &pifInfo);				// Non-zero return cancels the operation
+ * void draw(const pifINFO_t &pifInfo, uint32_t pixel);
+ * int8_t finish(pifINFO_t &pifInfo);				// Non-zero return is treated as an error
+ * @endcode
+ *
+ * @date	17.10.2026
+ * @author	gfcwfzkm
+ * @version 1
+ */
+
+#ifndef PIFDEC_HPP_
+#define PIFDEC_HPP_
+
+#include "pifdec_format.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__GNUC__)
+	#define PIF_HPP_ALWAYS_INLINE	inline __attribute__((always_inline))
+#else
+	#define PIF_HPP_ALWAYS_INLINE	inline
+#endif
+
+namespace pif {
+
+/** @brief Source reading an image straight out of RAM or memory mapped flash */
+class MemorySource {
+public:
+	/**
+	 * @param p8_data 	Pointer to the PIF image in memory
+	 * @param length 	Size of the PIF image in bytes
+	 */
+	MemorySource(const uint8_t *p8_data, size_t length) : p8_data(p8_data), length(length), pos(0) {}
+
+	/** Reading past the end of the image returns zeros, like \a pif_openMemory */
+	PIF_HPP_ALWAYS_INLINE uint8_t read8()
+	{
+		return (pos < length) ? p8_data[pos++] : 0;
+	}
+
+	void seek(uint32_t u32_filePos)
+	{
+		pos = u32_filePos;
+	}
+
+private:
+	const uint8_t *p8_data;
+	size_t length;
+	size_t pos;
+};
+
+/**
+ * @brief Source with a read-ahead buffer in front of a file
+ *
+ * The Reader policy is called once per block only, so it doesn't have to be inlined.
+ * It has to provide <tt>size_t read(uint8_t *p8_buf, size_t length)</tt>, returning the
+ * amount of bytes read, and <tt>void seek(uint32_t u32_filePos)</tt>. For FatFS:
+ * @code
+ * struct FatFsReader {
+ * 	FIL *p_file;
+ * 	size_t read(uint8_t *p8_buf, size_t length) { UINT br = 0; f_read(p_file, p8_buf, length, &br); return br; }
+ * 	void seek(uint32_t u32_filePos) { f_lseek(p_file, u32_filePos); }
+ * };
+ * @endcode
+ * @tparam Reader 		Reader policy
+ * @tparam BufferSize 	Size of the read-ahead buffer in bytes, 64 to 512 are a good choice
+ */
+template <class Reader, size_t BufferSize = 128>
+class BufferedSource {
+	static_assert(BufferSize > 0, "The read-ahead buffer needs at least one byte");
+public:
+	explicit BufferedSource(Reader &reader) : reader(reader), pos(0), fill(0) {}
+
+	PIF_HPP_ALWAYS_INLINE uint8_t read8()
+	{
+		if ((pos >= fill) && (refill() == 0))	return 0;
+		return buf[pos++];
+	}
+
+	void seek(uint32_t u32_filePos)
+	{
+		reader.seek(u32_filePos);
+		pos = 0;
+		fill = 0;
+	}
+
+private:
+	size_t refill()
+	{
+		pos = 0;
+		fill = reader.read(buf, BufferSize);
+		return fill;
+	}
+
+	Reader &reader;
+	size_t pos;
+	size_t fill;
+	uint8_t buf[BufferSize];
+};
+
+/**
+ * @brief Sink writing the pixels into a framebuffer
+ *
+ * Stores every pixel with PixelBytes bytes, least significant byte first, exactly as
+ * the decoder hands them over: RGB images in their own format, indexed images in the
+ * format of their color table (or the raw index if the color table is bypassed).
+ * @tparam PixelBytes 	Bytes per pixel within the framebuffer, 1 to 4
+ */
+template <uint8_t PixelBytes>
+class FramebufferSink {
+	static_assert((PixelBytes >= 1) && (PixelBytes <= 4), "Framebuffer pixels have 1 to 4 bytes");
+public:
+	/**
+	 * @param p_dst 		Pointer to the first pixel of the framebuffer
+	 * @param strideBytes 	Distance between the start of two rows in bytes
+	 */
+	FramebufferSink(void *p_dst, size_t strideBytes) : p8_dst(static_cast<uint8_t *>(p_dst)), stride(strideBytes) {}
+
+	int8_t prepare(pifINFO_t &) { return 0; }
+
+	PIF_HPP_ALWAYS_INLINE void draw(const pifINFO_t &pifInfo, uint32_t pixel)
+	{
+		uint8_t *p8_pixel = p8_dst + (size_t)(pifInfo.startY + pifInfo.currentY) * stride + (size_t)(pifInfo.startX + pifInfo.currentX) * PixelBytes;
+
+		for (uint8_t byteCnt = 0; byteCnt < PixelBytes; byteCnt++)
+		{
+			*p8_pixel++ = (uint8_t)pixel;
+			pixel >>= 8;
+		}
+	}
+
+	int8_t finish(pifINFO_t &) { return 0; }
+
+private:
+	uint8_t *p8_dst;
+	size_t stride;
+};
+
+/**
+ * @brief PIF decoder with the source and the display inlined
+ *
+ * The palette of indexed images is read once into the decoder (1kB), every enabled
+ * image format gets its own decoding loop with the color depth as constant.
+ * @tparam Source 	Source policy, like \a MemorySource or \a BufferedSource
+ * @tparam Sink 	Sink policy, like \a FramebufferSink or a display driver
+ */
+template <class Source, class Sink>
+class Decoder {
+public:
+	Decoder(Source &source, Sink &sink) : source(source), sink(sink), pifInfo(), bypassColTable(PIF_INDEXED_NORMAL_OPERATION) {}
+
+	/**
+	 * @brief Parse the header of the image at the start of the source
+	 * @return Returns \a pifRESULT ;PIF_RESULT_FORMATERR for unsupported or disabled images, otherwise PIF_RESULT_OK
+	 */
+	pifRESULT open()
+	{
+		source.seek(0);
+		return parseHeader();
+	}
+
+	/**
+	 * @brief Display the opened image
+	 *
+	 * Draws the image pixel by pixel through the sink, the same way \a pif_display does.
+	 * @param x0 	Start x position of the image on the screen, stored in pifINFO_t.startX
+	 * @param y0 	Start y position of the image on the screen, stored in pifINFO_t.startY
+	 * @return Returns \a pifRESULT ;PIF_RESULT_FORMATERR if the image data holds an invalid RLE instruction,
+	 * PIF_RESULT_DRAWERR if the sink returned an error, otherwise PIF_RESULT_OK
+	 */
+	pifRESULT display(uint16_t x0 = 0, uint16_t y0 = 0)
+	{
+		pifRESULT result = PIF_RESULT_OK;
+
+		pifInfo.startX = x0;
+		pifInfo.startY = y0;
+
+		if (sink.prepare(pifInfo))	return PIF_RESULT_DRAWERR;
+
+		pifInfo.currentX = 0;
+		pifInfo.currentY = 0;
+		switch (pifInfo.imageType)
+		{
+#if defined(PIF_ENABLE_RGB888)
+			case PIF_TYPE_RGB888:
+				result = decodeImage<PIF_TYPE_RGB888, 24>();
+				break;
+#endif
+#if defined(PIF_ENABLE_RGB565)
+			case PIF_TYPE_RGB565:
+				result = decodeImage<PIF_TYPE_RGB565, 16>();
+				break;
+#endif
+#if defined(PIF_ENABLE_RGB332)
+			case PIF_TYPE_RGB332:
+				result = decodeImage<PIF_TYPE_RGB332, 8>();
+				break;
+#endif
+#if defined(PIF_ENABLE_RGB16C)
+			case PIF_TYPE_RGB16C:
+				loadPalette16C();
+				result = decodeImage<PIF_TYPE_RGB16C, 4>();
+				break;
+#endif
+#if defined(PIF_ENABLE_BW)
+			case PIF_TYPE_BW:
+				loadPalette16C();
+				result = decodeImage<PIF_TYPE_BW, 1>();
+				break;
+#endif
+#if defined(PIF_ENABLE_IND8) || defined(PIF_ENABLE_IND16) || defined(PIF_ENABLE_IND24)
+			case PIF_TYPE_IND8:
+			case PIF_TYPE_IND16:
+			case PIF_TYPE_IND24:
+				loadPalette();
+				// Each packing of the indices gets its own loop. 5 to 7 bits are stored like 8 bits,
+				// more than 8 bits in words of two or three bytes
+				switch (pifInfo.bitsPerPixel)
+				{
+					case 1:		result = decodeImage<PIF_TYPE_IND8, 1>();	break;
+					case 2:		result = decodeImage<PIF_TYPE_IND8, 2>();	break;
+					case 3:		result = decodeImage<PIF_TYPE_IND8, 3>();	break;
+					case 4:		result = decodeImage<PIF_TYPE_IND8, 4>();	break;
+					default:
+						if (pifInfo.bitsPerPixel > 16)		result = decodeImage<PIF_TYPE_IND8, 24>();
+						else if (pifInfo.bitsPerPixel > 8)	result = decodeImage<PIF_TYPE_IND8, 16>();
+						else								result = decodeImage<PIF_TYPE_IND8, 8>();
+						break;
+				}
+				break;
+#endif
+			default:
+				return PIF_RESULT_FORMATERR;
+		}
+
+		// Like pif_display, the sink is finished with what came in front of invalid image data
+		if (sink.finish(pifInfo) && (result == PIF_RESULT_OK))	result = PIF_RESULT_DRAWERR;
+		return result;
+	}
+
+	/** Send the index values of indexed images to the sink, instead of looking up their colors */
+	void setBypass(pifIndexedBypass bypass)
+	{
+		bypassColTable = bypass;
+	}
+
+	/** Information about the opened image */
+	const pifINFO_t &info() const
+	{
+		return pifInfo;
+	}
+
+private:
+	PIF_HPP_ALWAYS_INLINE uint16_t read16()
+	{
+		const uint16_t low = source.read8();
+		return (uint16_t)(source.read8() << 8) | low;
+	}
+
+	/* Read a word of image data, 1 to 3 bytes */
+	template <uint8_t BitsPerPixel>
+	PIF_HPP_ALWAYS_INLINE uint32_t readWord()
+	{
+		uint32_t pixelData = source.read8();
+
+		if constexpr (BitsPerPixel > 8)		pixelData |= (uint32_t)source.read8() << 8;
+		if constexpr (BitsPerPixel > 16)	pixelData |= (uint32_t)source.read8() << 16;
+		return pixelData;
+	}
+
+	pifRESULT parseHeader()
+	{
+		uint8_t header[PIF_HEADER_SIZE];
+
+		for (uint8_t byteCnt = 0; byteCnt < PIF_HEADER_SIZE; byteCnt++)	header[byteCnt] = source.read8();
+		// Whole images are always decoded from the start, a row index in the file isn't needed
+		return _pifDecodeHeader(header, &pifInfo);
+	}
+
+	/* Read the whole color table once. Like pif_display, indices past the end of the
+	 * color table read whatever follows it in the file */
+	void loadPalette()
+	{
+		const uint8_t colorSize = pifInfo.imageType & PIF_MASK_INDEXED_COLOR_SIZE;
+		const uint16_t entries = (uint16_t)1 << ((pifInfo.bitsPerPixel < 8) ? pifInfo.bitsPerPixel : 8);
+
+		if (bypassColTable != PIF_INDEXED_NORMAL_OPERATION)	return;
+
+		source.seek(PIF_FORMAT_COLORTABLE_OFFSET);
+		for (uint16_t colorCnt = 0; colorCnt < entries; colorCnt++)
+		{
+			uint32_t color = source.read8();
+			if (colorSize > 1)	color |= (uint32_t)source.read8() << 8;
+			if (colorSize > 2)	color |= (uint32_t)source.read8() << 16;
+			palette[colorCnt] = color;
+		}
+	}
+
+#if defined(PIF_USE_TABLE_16C)
+	/* BW and RGB16C use the embedded 16 color table */
+	void loadPalette16C()
+	{
+		for (uint8_t colorCnt = 0; colorCnt < 16; colorCnt++)
+		{
+			palette[colorCnt] = _pifGetColor16C(pifInfo.imageType, colorCnt);
+		}
+	}
+#endif
+
+	/* Send a single pixel to the sink and move on to the next position */
+	PIF_HPP_ALWAYS_INLINE void drawPixel(uint32_t pixel)
+	{
+		// Padding bits after the last pixel of the image are ignored
+		if (pifInfo.currentY >= pifInfo.imageHeight)	return;
+
+		sink.draw(pifInfo, pixel);
+		if (++pifInfo.currentX >= pifInfo.imageWidth)
+		{
+			pifInfo.currentX = 0;
+			pifInfo.currentY++;
+		}
+	}
+
+	PIF_HPP_ALWAYS_INLINE void drawIndex(uint8_t index)
+	{
+		drawPixel((bypassColTable != PIF_INDEXED_NORMAL_OPERATION) ? index : palette[index]);
+	}
+
+	/* Draw a word of image data, the indices of indexed images are unpacked like in pifdec.c */
+	template <pifImageType ImageType, uint8_t BitsPerPixel>
+	PIF_HPP_ALWAYS_INLINE void processWord(uint32_t pixelData)
+	{
+		if constexpr (ImageType <= PIF_TYPE_RGB332)
+		{
+			drawPixel(pixelData);
+		}
+		else
+		{
+			uint8_t index[8];
+			const uint8_t pixelLimit = _pifUnpackGroup((uint8_t)pixelData, BitsPerPixel, index);
+
+			for (uint8_t pixelCounter = 0; pixelCounter < pixelLimit; pixelCounter++)	drawIndex(index[pixelCounter]);
+		}
+	}
+
+	template <pifImageType ImageType, uint8_t BitsPerPixel>
+	pifRESULT decodeImage()
+	{
+		const uint8_t wordBytes = _pifWordBytes(BitsPerPixel);
+
+		source.seek(pifInfo.imageOffset);
+		if (pifInfo.compression != PIF_COMPRESSION_NONE)
+		{
+			int16_t rleInstr;
+
+			for (uint32_t filePos = 0; filePos < pifInfo.imageSize;)
+			{
+				// Load the next RLE instruction
+				rleInstr = (int8_t)source.read8();
+				filePos++;
+				if ((rleInstr == 0) && (pifInfo.compression == PIF_COMPRESSION_RLE_EXT))
+				{
+					// Extended RLE: The instruction follows as int16
+					rleInstr = _pifExtInstr(read16());
+					filePos += 2;
+					if (rleInstr == 0)	return PIF_RESULT_FORMATERR;
+				}
+				if (rleInstr > 0)
+				{
+					// RLE Instruction is positive: Send the word rleInst-amount of times
+					if (filePos >= pifInfo.imageSize)	break;
+					const uint32_t pixelData = readWord<BitsPerPixel>();
+					filePos += wordBytes;
+					for (; rleInstr > 0; rleInstr--)	processWord<ImageType, BitsPerPixel>(pixelData);
+				}
+				else
+				{
+					// RLE Instruction is negative: The next (rleInst * -1)-amount of words are uncompressed
+					for (; (rleInstr < 0) && (filePos < pifInfo.imageSize); rleInstr++)
+					{
+						processWord<ImageType, BitsPerPixel>(readWord<BitsPerPixel>());
+						filePos += wordBytes;
+					}
+				}
+			}
+		}
+		else
+		{
+			while (pifInfo.currentY < pifInfo.imageHeight)
+			{
+				processWord<ImageType, BitsPerPixel>(readWord<BitsPerPixel>());
+			}
+		}
+		return PIF_RESULT_OK;
+	}
+
+	Source &source;
+	Sink &sink;
+	pifINFO_t pifInfo;
+	pifIndexedBypass bypassColTable;
+	uint32_t palette[256];
+};
+
+} // namespace pif
+
+#endif /* PIFDEC_HPP_ */
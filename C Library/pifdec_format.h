@@ -0,0 +1,362 @@
+/*
+ * pifdec_format.h
+ *
+ * PIF Decoder Library, definitions of the file format
+ * Copyright (c) 2022 gfcwfzkm ( gfcwfzkm@protonmail.com )
+ * License: GNU Lesser General Public License, Version 2.1
+ * 		http://www.gnu.org/licenses/lgpl-2.1.html
+ *
+ * Shared by pifdec.c and pifdec.hpp, so both decoders read the images the same way:
+ * The constants of the format, the embedded 16 color table, the image header, the
+ * extended RLE instruction and the packing of the pixels into words of image data.
+ * Applications include pifdec.h or pifdec.hpp instead of this file.
+ *
+ * Created: 17.10.2026
+ *  Author: gfcwfzkm
+ */
+
+#ifndef PIFDEC_FORMAT_H_
+#define PIFDEC_FORMAT_H_
+
+#include "pifdec.h"
+
+#if defined(AVR) && !defined(__GNUG__)
+	#include <avr/pgmspace.h>
+	#define _PMEMX	__memx
+	#define _PRGM
+#elif defined(AVR) && defined(__GNUG__)
+	#include <avr/pgmspace.h>
+	#define ARDUINO_IN_USE
+	#define _PMEMX
+	#define _PRGM	PROGMEM
+#else
+	#define _PMEMX
+	#define _PRGM
+#endif
+
+// The 16 color table is only required by RGB16C and BW images
+#if defined(PIF_ENABLE_RGB16C) || defined(PIF_ENABLE_BW)
+	#define PIF_USE_TABLE_16C
+#endif
+
+
+#if defined(PIF_USE_TABLE_16C)
+// CGA / 16 Color palette generated with the following formula:
+// red	 = 255 * (2/3 * (colorNumber & 4)/4 + 1/3 * (colorNumber & 8)/8 )
+// green = 255 * (2/3 * (colorNumber & 2)/2 + 1/3 * (colorNumber & 8)/8 )
+// blue	 = 255 * (2/3 * (colorNumber & 1)/1 + 1/3 * (colorNumber & 8)/8 )
+#if defined(PIF_RGB16C_RGB888)
+static const _PMEMX uint8_t color_table_16C[48] _PRGM = {
+	0, 0, 0,		// black
+	0, 0, 170,		// blue
+	0, 170, 0,		// green
+	0, 170, 170,	// cyan
+	170, 0, 0,		// red
+	170, 0, 170,	// magenta
+	170, 170, 0,	// dark yellow
+	170, 170, 170,	// light gray
+	85, 85, 85,		// dark gray
+	85, 85, 255,	// light blue
+	85, 255, 85,	// light green
+	85, 255, 255,	// light cyan
+	255, 85, 85,	// light red
+	255, 85, 255,	// light magenta
+	255, 255, 85,	// yellow
+	255, 255, 255	// white
+};
+#elif defined(PIF_RGB16C_RGB565)
+static const _PMEMX uint8_t color_table_16C[32] _PRGM = {
+	0x00, 0x00,	// black
+	0x00, 0x15,	// blue
+	0x05, 0x40,	// green
+	0x05, 0x55,	// cyan
+	0xA8, 0x0,	// red
+	0xA8, 0x15,	// magenta
+	0xAD, 0x40,	// dark yellow
+	0xAD, 0x55,	// light gray
+	0x52, 0xAA,	// dark gray
+	0x52, 0xBF,	// light blue
+	0x57, 0xEA,	// light green
+	0x57, 0xFF,	// light cyan
+	0xFA, 0xAA,	// light red
+	0xFA, 0xBF,	// light magenta
+	0xFF, 0xEA,	// yellow
+	0xFF, 0xFF	// white
+};
+#elif defined(PIF_RGB16C_RGB332)
+static const _PMEMX uint8_t color_table_16C[16] _PRGM = {
+	0x00,	// black
+	0x02,	// blue
+	0x14,	// green
+	0x16,	// cyan
+	0xA0,	// red
+	0xA2,	// magenta
+	0xB4,	// dark yellow
+	0xB6,	// light gray
+	0x49,	// dark gray
+	0x4B,	// light blue
+	0x5D,	// light green
+	0x5F,	// light cyan
+	0xF5,	// light red
+	0xEB,	// light magenta
+	0xFD,	// yellow
+	0xFF	// white
+};
+#else
+	#error "You need to configure which color-format you want to use for the RGB16C image mode!"
+#endif
+#endif /* PIF_USE_TABLE_16C */
+
+#define PIF_MONOCHROME_BLACK	0x000000
+#define PIF_MONOCHROME_WHITE	0xFFFFFF
+
+#define PIF_FORMAT_HEADER	0x00464950	// 'PIF\0' as String in LittleEndian
+#define PIF_FORMAT_RGB888	0x433C
+#define PIF_FORMAT_RGB565	0xE5C5
+#define PIF_FORMAT_RGB332	0x1E53
+#define PIF_FORMAT_RGB16C	0xB895
+#define PIF_FORMAT_BW		0x7DAA
+#define PIF_FORMAT_IND24	0x4952
+#define PIF_FORMAT_IND16	0x4947
+#define PIF_FORMAT_IND8		0x4942
+#define PIF_FORMAT_COMPR	0x7DDE
+#define PIF_FORMAT_COMPR_EXT	0x7DDF	// RLE, with a 16 bit count following a zero instruction byte
+#define PIF_FORMAT_RLE_EXT_MAX	8191	// Longest extended run or literal block in words, keeps the pixel counts within 16 bit
+#define PIF_FORMAT_COLORTABLE_OFFSET	0x1C
+#define PIF_FORMAT_ROWINDEX		0x58444952	// 'RIDX' as String in LittleEndian, optional row index behind the color table
+#define PIF_FORMAT_ROWINDEX_HEADER	8		// Magic, rows between two entries and amount of entries
+#define PIF_FORMAT_ROWINDEX_ENTRY	6		// Offset within the image data and pixels in front of the row
+#define PIF_CATALOG_MAGIC		0x43464950	// 'PIFC' as String in LittleEndian
+#define PIF_CATALOG_VERSION		1
+#define PIF_CATALOG_HEADER		16			// Magic, version, entry size, amount of entries, reserved
+#define PIF_CATALOG_ENTRY		28			// Path hash followed by the image header without its magic
+#define PIF_MASK_INDEXED_COLOR_SIZE		0x03
+#define PIF_MASK_INDEXED_MODE_IN_USE	0x04
+
+// Color format of the embedded RGB16C lookup table
+#if defined(PIF_RGB16C_RGB888)
+	#define PIF_RGB16C_FORMAT	PIF_TYPE_RGB888
+#elif defined(PIF_RGB16C_RGB565)
+	#define PIF_RGB16C_FORMAT	PIF_TYPE_RGB565
+#else
+	#define PIF_RGB16C_FORMAT	PIF_TYPE_RGB332
+#endif
+
+#if defined(PIF_USE_TABLE_16C)
+/* Read the static color table for BW / RGB16C */
+static inline uint32_t _pifGetRGB16C(uint8_t color)
+{
+#if defined(ARDUINO_IN_USE)
+	#warning "Arduino static indexed colors not fully tested - be aware!"
+	#if defined(PIF_RGB16C_RGB888)
+		return ((uint32_t)pgm_read_dword(&(color_table_16C[color * 3])) << 16) | ((uint32_t)pgm_read_dword(&(color_table_16C[color * 3 + 1))] << 8) | (pgm_read_dword(&(color_table_16C[color * 3 + 2])));
+	#elif defined(PIF_RGB16C_RGB565)
+		return ((uint32_t)pgm_read_dword(&(color_table_16C[color * 2])) << 8) | ((uint32_t)pgm_read_dword(&(color_table_16C[color * 2 + 1])));
+	#elif defined(PIF_RGB16C_RGB332)
+		return ((uint32_t)pgm_read_dword(&(color_table_16C[color])));
+	#else
+		#error "You need to configure which color-format you want to use for the RGB16C image mode!"
+	#endif
+#else
+	#if defined(PIF_RGB16C_RGB888)
+		return ((uint32_t)color_table_16C[color * 3] << 16) | ((uint32_t)color_table_16C[color * 3 + 1] << 8) | (color_table_16C[color * 3 + 2]);
+	#elif defined(PIF_RGB16C_RGB565)
+		return ((uint32_t)color_table_16C[color * 2] << 8) | ((uint32_t)color_table_16C[color * 2 + 1]);
+	#elif defined(PIF_RGB16C_RGB332)
+		return ((uint32_t)color_table_16C[color]);
+	#else
+		#error "You need to configure which color-format you want to use for the RGB16C image mode!"
+	#endif
+#endif
+}
+
+/* Color of an index of a BW or RGB16C image, BW images use black and white of the 16 color table */
+static inline uint32_t _pifGetColor16C(pifImageType imageType, uint8_t index)
+{
+	if (imageType == PIF_TYPE_BW)	return (index & 1) ? _pifGetRGB16C(15) : _pifGetRGB16C(0);
+	return _pifGetRGB16C(index & 0x0F);
+}
+#endif /* PIF_USE_TABLE_16C */
+
+/* Little endian values inside an already read header */
+static inline uint16_t _pifGet16(const uint8_t *p8_data)
+{
+	return (uint16_t)p8_data[1] << 8 | p8_data[0];
+}
+
+static inline uint32_t _pifGet32(const uint8_t *p8_data)
+{
+	return (uint32_t)p8_data[3] << 24 | (uint32_t)p8_data[2] << 16 | (uint32_t)p8_data[1] << 8 | p8_data[0];
+}
+
+/* Decode and check the 28 byte image header. Needs no handle and no I/O at all */
+static inline pifRESULT _pifDecodeHeader(const uint8_t *p8_header, pifINFO_t *p_info)
+{
+	int8_t results = 0;
+	uint16_t tempVar;
+	
+	// Interpret the PIF image header
+	if (_pifGet32(&p8_header[0]) != PIF_FORMAT_HEADER)
+	{
+		// Not the file we expected!
+		return PIF_RESULT_FORMATERR;
+	}
+	
+	p_info->fileSize = _pifGet32(&p8_header[4]);
+	p_info->imageOffset = _pifGet32(&p8_header[8]);
+	
+	tempVar = _pifGet16(&p8_header[12]);
+	switch(tempVar)
+	{
+#if defined(PIF_ENABLE_RGB888)
+		case PIF_FORMAT_RGB888:
+			p_info->imageType = PIF_TYPE_RGB888;
+			break;
+#endif
+#if defined(PIF_ENABLE_RGB565)
+		case PIF_FORMAT_RGB565:
+			p_info->imageType = PIF_TYPE_RGB565;
+			break;
+#endif
+#if defined(PIF_ENABLE_RGB332)
+		case PIF_FORMAT_RGB332:
+			p_info->imageType = PIF_TYPE_RGB332;
+			break;
+#endif
+#if defined(PIF_ENABLE_RGB16C)
+		case PIF_FORMAT_RGB16C:
+			p_info->imageType = PIF_TYPE_RGB16C;
+			break;
+#endif
+#if defined(PIF_ENABLE_BW)
+		case PIF_FORMAT_BW:
+			p_info->imageType = PIF_TYPE_BW;
+			break;
+#endif
+#if defined(PIF_ENABLE_IND24)
+		case PIF_FORMAT_IND24:
+			p_info->imageType = PIF_TYPE_IND24;
+			break;
+#endif
+#if defined(PIF_ENABLE_IND16)
+		case PIF_FORMAT_IND16:
+			p_info->imageType = PIF_TYPE_IND16;
+			break;
+#endif
+#if defined(PIF_ENABLE_IND8)
+		case PIF_FORMAT_IND8:
+			p_info->imageType = PIF_TYPE_IND8;
+			break;
+#endif
+		default:
+			// Unsupported image type
+			results |= 1;
+	}
+	p_info->bitsPerPixel = _pifGet16(&p8_header[14]);
+	// The decoding loops of the non-indexed formats rely on their fixed color depth,
+	// indexed images are read in words of one to three bytes
+	if (((p_info->imageType == PIF_TYPE_RGB888) && (p_info->bitsPerPixel != 24)) ||
+		((p_info->imageType == PIF_TYPE_RGB565) && (p_info->bitsPerPixel != 16)) ||
+		((p_info->imageType == PIF_TYPE_RGB332) && (p_info->bitsPerPixel != 8)) ||
+		((p_info->imageType == PIF_TYPE_RGB16C) && (p_info->bitsPerPixel != 4)) ||
+		((p_info->imageType == PIF_TYPE_BW) && (p_info->bitsPerPixel != 1)) ||
+		((p_info->imageType > PIF_TYPE_BW) && ((p_info->bitsPerPixel == 0) || (p_info->bitsPerPixel > 24))))
+	{
+		results |= 1;
+	}
+	p_info->imageWidth = _pifGet16(&p8_header[16]);
+	p_info->imageHeight = _pifGet16(&p8_header[18]);
+	p_info->imageSize = _pifGet32(&p8_header[20]);
+	p_info->colTableSize = _pifGet16(&p8_header[24]);
+	
+	tempVar = _pifGet16(&p8_header[26]);
+	if (tempVar == PIF_FORMAT_COMPR)
+	{
+		p_info->compression = PIF_COMPRESSION_RLE;
+	}
+	else if (tempVar == PIF_FORMAT_COMPR_EXT)
+	{
+		p_info->compression = PIF_COMPRESSION_RLE_EXT;
+	}
+	else if (tempVar == 0)
+	{
+		p_info->compression = PIF_COMPRESSION_NONE;
+	}
+	else
+	{
+		// Unsupported compression
+		results |= 1;
+	}
+	
+	p_info->startX = 0;
+	p_info->startY = 0;
+	p_info->currentX = 0;
+	p_info->currentY = 0;
+	p_info->regionX = 0;
+	p_info->regionY = 0;
+	p_info->regionWidth = p_info->imageWidth;
+	p_info->regionHeight = p_info->imageHeight;
+	p_info->fileRowIndexStep = 0;
+	
+	return (results) ? PIF_RESULT_FORMATERR : PIF_RESULT_OK;
+}
+
+/* Bytes per word of image data: Pixels of less than 8 bits are packed into a byte, indexed
+ * images of more than 8 bits per pixel use two or three bytes per word like RGB565 / RGB888 */
+static inline uint8_t _pifWordBytes(uint8_t bitsPerPixel)
+{
+	return (bitsPerPixel <= 8) ? 1 : (bitsPerPixel <= 16) ? 2 : 3;
+}
+
+/* Pixels per word of image data, 3 bit pixels are stored like 4 bit pixels */
+static inline uint8_t _pifWordPixels(uint8_t bitsPerPixel)
+{
+	return (bitsPerPixel == 1) ? 8 : (bitsPerPixel == 2) ? 4 : (bitsPerPixel <= 4) ? 2 : 1;
+}
+
+/* Split a byte of indexed image data into the indices of its pixels, using constant
+ * shifts only (variable shifts are expensive on 8-bit MCUs). Returns the amount of pixels.
+ * Words of more than 8 bits per pixel hold a single pixel, indexed by their low byte */
+static inline uint8_t _pifUnpackGroup(uint8_t pixelGroup, uint8_t bitsPerPixel, uint8_t *p8_index)
+{
+	switch (bitsPerPixel)
+	{
+		case 1:
+			for (uint8_t pixelCounter = 0; pixelCounter < 8; pixelCounter++)
+			{
+				p8_index[pixelCounter] = pixelGroup & 0x01;
+				pixelGroup >>= 1;
+			}
+			return 8;
+		case 2:
+			p8_index[0] = pixelGroup & 0x03;
+			p8_index[1] = (pixelGroup >> 2) & 0x03;
+			p8_index[2] = (pixelGroup >> 4) & 0x03;
+			p8_index[3] = pixelGroup >> 6;
+			return 4;
+		case 3:
+			// 3 bit pixels are stored like 4 bit pixels
+			p8_index[0] = pixelGroup & 0x07;
+			p8_index[1] = (pixelGroup >> 4) & 0x07;
+			return 2;
+		case 4:
+			p8_index[0] = pixelGroup & 0x0F;
+			p8_index[1] = pixelGroup >> 4;
+			return 2;
+		default:
+			p8_index[0] = pixelGroup;
+			return 1;
+	}
+}
+
+/* Count of an extended RLE instruction. Counts beyond PIF_FORMAT_RLE_EXT_MAX words are invalid
+ * image data, just like a count of zero, and return zero */
+static inline int16_t _pifExtInstr(uint16_t u16_count)
+{
+	const int16_t count = (int16_t)u16_count;
+	
+	if ((count > PIF_FORMAT_RLE_EXT_MAX) || (count < -PIF_FORMAT_RLE_EXT_MAX))	return 0;
+	return count;
+}
+
+#endif /* PIFDEC_FORMAT_H_ */
@@ -484,10 +484,49 @@ def convertToPIF(image, resize, conversion, colorLength, colorTable, dithering,
 	return imageHeader,imageColors,imageData,rlePos
 
 # Python is annoying with that stuff, should have used C#
+#########################################################################
+#                         RLE Row Index                                 #
+#########################################################################
+# Stores for every everyNRows-th row the offset of the RLE instruction holding its first pixel
+# (relative to the image data) and the amount of pixels of that instruction in front of the row.
+# Placed between the color table and the image data: 'RIDX', rows per entry, amount of entries,
+# followed by the entries as uint32 offset and uint16 pixels, all little endian
+def rowIndexBlock(imageData, bitsPerPixel, imageWidth, imageHeight, everyNRows):
+	wordBytes = 1 if bitsPerPixel < 8 else bitsPerPixel // 8
+	wordPixels = 8 if bitsPerPixel == 1 else 4 if bitsPerPixel == 2 else 2 if bitsPerPixel <= 4 else 1
+	entries = (imageHeight + everyNRows - 1) // everyNRows
+	rowIndex = []
+	rowPixel = 0
+	pixelPos = 0
+	instrPos = 0
+
+	while (instrPos < len(imageData)) and (len(rowIndex) < entries):
+		rleInstruction = imageData[instrPos] - 256 if imageData[instrPos] > 127 else imageData[instrPos]
+		runPixels = abs(rleInstruction) * wordPixels
+		while (rowPixel < pixelPos + runPixels) and (len(rowIndex) < entries):
+			rowIndex.append((instrPos, rowPixel - pixelPos))
+			rowPixel += everyNRows * imageWidth
+		pixelPos += runPixels
+		if (rleInstruction < 0):
+			instrPos += 1 - rleInstruction * wordBytes
+		elif (rleInstruction > 0):
+			instrPos += 1 + wordBytes
+		else:
+			instrPos += 1
+
+	# Rows without any data point to the end of the image data
+	while (len(rowIndex) < entries):
+		rowIndex.append((len(imageData), 0))
+
+	block = [0x52, 0x49, 0x44, 0x58, everyNRows & 0xFF, (everyNRows & 0xFF00) >> 8, entries & 0xFF, (entries & 0xFF00) >> 8]
+	for offset, pixels in rowIndex:
+		block.extend([offset & 0xFF, (offset & 0xFF00) >> 8, (offset & 0xFF0000) >> 16, (offset & 0xFF000000) >> 24, pixels & 0xFF, (pixels & 0xFF00) >> 8])
+	return block
+
 #########################################################################
 #                         Save PIF as binary                            #
 #########################################################################
-def savePIFbinary(imageHeader, colorTable, imageData, rlePos, path):
+def savePIFbinary(imageHeader, colorTable, imageData, rlePos, path, rowIndexRows = 0):
 	# I'm old school, so I wanna allocate the space before processing the data
 	tTotalPIF = []
 	tPIFHeader = [None] * 12
@@ -560,6 +599,9 @@ def savePIFbinary(imageHeader, colorTable, imageData, rlePos, path):
 	tTotalPIF.extend(tImgHeader)
 	if (imageHeader[5] > 0):
 		tTotalPIF.extend(tColTable)
+	# Optional row index of RLE images, skipped by decoders without support through the image offset
+	if ((imageHeader[6] != 0) and (rowIndexRows > 0)):
+		tTotalPIF.extend(rowIndexBlock(tImgData, imageHeader[1], imageHeader[2], imageHeader[3], rowIndexRows))
 	iStart = len(tTotalPIF)
 	tTotalPIF.extend(tImgData)
 	iSize = len(tTotalPIF)
@@ -1042,7 +1084,8 @@ def main():
 		],
 		[sg.Frame('Compression Type', [
 			[sg.Radio('No Compression at all', 2, key='-RB_COMP_NO-', default=True)],
-			[sg.Radio('Basic RLE Compression', 2, key='-RB_COMP_RLE-')]],
+			[sg.Radio('Basic RLE Compression', 2, key='-RB_COMP_RLE-')],
+			[sg.Checkbox('RLE row index every', key='-CB_ROWIDX-'), sg.Input('16', key='-IN_ROWIDX-', size=(5,1)), sg.Text('rows')]],
 			expand_x=True)
 		],
 		[sg.Frame('Dithering Settings', [
@@ -1158,7 +1201,8 @@ def main():
 				if values['-RB_COL_16B-'] == True:	conType = ConversionType.RGB565
 				if values['-RB_COL_24B-'] == True:	conType = ConversionType.RGB888
 				imageHeader, colorTable, imageData, rlePos = convertToPIF(OriginalImage, ((int)(values['-IN_SIZE_X-']),(int)(values['-IN_SIZE_Y-'])), conType, ColorIndexLength, ColorIndexTable, values['-RB_DIT_FS-'], values['-RB_COMP_RLE-'])
-				isize = savePIFbinary(imageHeader, colorTable, imageData, rlePos, filename)
+				rowIndexRows = min(max((int)(values['-IN_ROWIDX-']), 1), 0xFFFF) if values['-CB_ROWIDX-'] else 0
+				isize = savePIFbinary(imageHeader, colorTable, imageData, rlePos, filename, rowIndexRows)
 				compression = values['-RB_COMP_RLE-']
 				file_saved(conType.name, compression, isize)
 
@@ -17,6 +17,15 @@ class PIF():
 	COLORTABLE_OFFSET : Literal
 		Defines the end of the PIF header and the start of the
 		optional color table
+
+	ROWINDEX_MAGIC : list[int]
+		Magic bytes of the optional row index, which is stored
+		between the color table and the image data
+
+	RLE_EXT_MAX : Literal
+		Longest run or literal block of a single extended RLE
+		instruction, in words. Larger counts are invalid and
+		raise a ValueError when decoding
 	
 	Subclasses
 	----------
@@ -35,8 +44,8 @@ class PIF():
 		Decodes the PIF image / data and returns a pillow image and file information
 	
 	encodeFile(image: PIL.Image.Image, imageType: PIFType, compression: CompressionType,
-			IndexedColorTable: None | tuple[np.ndarray, int], dithering: bool = False) -> np.ndarray:
-		Converts an pillow image to a PIF image with the given arguments
+			IndexedColorTable: None | tuple[np.ndarray, int], dithering: bool = False, rowIndexRows: int = 0) -> np.ndarray:
+		Converts an pillow image to a PIF image with the given arguments, optionally with a row index
 	
 	encodePreview(image: PIL.Image.Image, imageType: PIFType, IndexedColorTable: None | tuple[np.ndarray, int],
 			dithering: bool = False) -> PIL.Image.Image:
@@ -65,9 +74,14 @@ class PIF():
 
 	COLORTABLE_OFFSET = 28
 
+	ROWINDEX_MAGIC = [0x52, 0x49, 0x44, 0x58]	# 'RIDX'
+
+	RLE_EXT_MAX = 8191
+
 	class CompressionType(Enum):
 		NO_COMPRESSION 	= 0
 		RLE_COMPRESSION = 0x7DDE
+		RLE_EXT_COMPRESSION = 0x7DDF	# RLE with 16 bit counts for long runs and literal blocks
 
 	class PIFType(Enum):
 		ImageTypeRGB888 = 0x433C
@@ -91,13 +105,15 @@ class PIF():
 			self.colorTableSize = None	# integer
 			self.colorTable = None	# numpy.ndarray, 1D
 			self.compression = PIF.CompressionType.NO_COMPRESSION
+			self.rowIndexRows = 0	# integer, rows between two row index entries, 0 without row index
+			self.rowIndex = None	# list of (offset, pixels) tuples
 			self.rawImageData = None # numpy.ndarray, 1D
 
 	def __init__(self) -> None:
 		# Not in use
 		pass
 
-	def __decomplressRLE(rleData: np.ndarray, bitsPerPixel: int, imageSize: int) -> np.ndarray:
+	def __decomplressRLE(rleData: np.ndarray, bitsPerPixel: int, imageSize: int, extended: bool = False) -> np.ndarray:
 		"""
 		Decompress RLE data
 
@@ -112,12 +128,14 @@ class PIF():
 			Amount of bits per pixel, in order to decompress the data correctly
 		imageSize : PIFInfo
 			Amount of Pixels to decode / expect
+		extended : bool
+			Extended RLE, where a zero instruction byte is followed by a 16 bit instruction
 
 		Returns : numpy.ndarray
 			Decompressed image data
 		"""
 		rleInstruction = 0
-		imageData = np.zeros(3, dtype=np.int8)
+		imageData = np.zeros(3, dtype=np.uint8)
 		imagePointer = 0
 		dataCounter = 0
 
@@ -176,7 +194,15 @@ class PIF():
 			
 			else:
 				# RLE Instruction is 0: The next byte is a RLE Instruction
-				rleInstruction = imageData[0]
+				rleInstruction = int(imageData[0])
+				if (rleInstruction > 127):	rleInstruction -= 256
+				if (extended and rleInstruction == 0):
+					# Extended RLE: The instruction is stored as signed 16 bit value behind the zero byte
+					rleInstruction = int(rleData[dataCounter + 1]) + (int(rleData[dataCounter + 2]) << 8)
+					if (rleInstruction > 32767):	rleInstruction -= 65536
+					if (rleInstruction == 0 or abs(rleInstruction) > PIF.RLE_EXT_MAX):
+						raise ValueError(f'Invalid extended RLE instruction {rleInstruction} at offset {dataCounter}')
+					dataCounter += 2
 			
 			dataCounter += 1
 		
@@ -326,26 +352,35 @@ class PIF():
 
 		# So far so good, trying to parse in the data
 		imageInfo.fileSize = PIFdata.size
-		imageInfo.imageOffset = PIFdata[8] + (PIFdata[9] << 8) + (PIFdata[10] << 16) + (PIFdata[11] << 24)
-		imageInfo.imageType = PIFdata[12] + (PIFdata[13] << 8)
-		imageInfo.bitsPerPixel = PIFdata[14] + (PIFdata[15] << 8)
-		imageInfo.imageWidth = PIFdata[16] + (PIFdata[17] << 8)
-		imageInfo.imageHeigt = PIFdata[18] + (PIFdata[19] << 8)
-		imageInfo.imageSize = PIFdata[20] + (PIFdata[21] << 8) + (PIFdata[22] << 16) + (PIFdata[23] << 24)
-		imageInfo.colorTableSize = PIFdata[24] + (PIFdata[25] << 8)
-		imageInfo.compression = PIFdata[26] + (PIFdata[27] << 8)
+		imageInfo.imageOffset = int(PIFdata[8]) + (int(PIFdata[9]) << 8) + (int(PIFdata[10]) << 16) + (int(PIFdata[11]) << 24)
+		imageInfo.imageType = int(PIFdata[12]) + (int(PIFdata[13]) << 8)
+		imageInfo.bitsPerPixel = int(PIFdata[14]) + (int(PIFdata[15]) << 8)
+		imageInfo.imageWidth = int(PIFdata[16]) + (int(PIFdata[17]) << 8)
+		imageInfo.imageHeigt = int(PIFdata[18]) + (int(PIFdata[19]) << 8)
+		imageInfo.imageSize = int(PIFdata[20]) + (int(PIFdata[21]) << 8) + (int(PIFdata[22]) << 16) + (int(PIFdata[23]) << 24)
+		imageInfo.colorTableSize = int(PIFdata[24]) + (int(PIFdata[25]) << 8)
+		imageInfo.compression = int(PIFdata[26]) + (int(PIFdata[27]) << 8)
 
 		# Sanity-Check some things, python's enums should raise error if not found
 		imageInfo.imageType = PIF.PIFType(imageInfo.imageType)
 		imageInfo.compression = PIF.CompressionType(imageInfo.compression)
 			
+		# Optional row index between the color table and the image data
+		indexStart = PIF.COLORTABLE_OFFSET + imageInfo.colorTableSize
+		if (imageInfo.imageOffset >= indexStart + 8) and (list(PIFdata[indexStart : indexStart + 4]) == PIF.ROWINDEX_MAGIC):
+			imageInfo.rowIndexRows = int(PIFdata[indexStart + 4]) + (int(PIFdata[indexStart + 5]) << 8)
+			entries = int(PIFdata[indexStart + 6]) + (int(PIFdata[indexStart + 7]) << 8)
+			entryData = PIFdata[indexStart + 8 : indexStart + 8 + entries * 6].astype(np.uint32).reshape(-1, 6)
+			imageInfo.rowIndex = [(int(e[0] + (e[1] << 8) + (e[2] << 16) + (e[3] << 24)), int(e[4] + (e[5] << 8))) for e in entryData]
+
 		# Raw image data to process
 		imageInfo.rawImageData = np.copy(PIFdata[imageInfo.imageOffset : imageInfo.imageOffset + imageInfo.imageSize])
 
 		# Check if the image is compressed
-		if (imageInfo.compression == PIF.CompressionType.RLE_COMPRESSION):
+		if (imageInfo.compression != PIF.CompressionType.NO_COMPRESSION):
 			# Decompress the image data first
-			imageInfo.rawImageData = PIF.__decomplressRLE(imageInfo.rawImageData, imageInfo.bitsPerPixel, imageInfo.imageWidth * imageInfo.imageHeigt)
+			imageInfo.rawImageData = PIF.__decomplressRLE(imageInfo.rawImageData, imageInfo.bitsPerPixel, imageInfo.imageWidth * imageInfo.imageHeigt,
+				imageInfo.compression == PIF.CompressionType.RLE_EXT_COMPRESSION)
 		
 		# Need a pure RGB888 image for further processing...
 		if (imageInfo.imageType != PIF.PIFType.ImageTypeRGB888) and ((imageInfo.imageType.value & 0xFF00) != (PIF.PIFType.ImageTypeIND16.value & 0xFF00)):
@@ -470,6 +505,61 @@ class PIF():
 		rlePos.append(None)
 		return rlePos,outlist
 	
+	def __rleCompressExtended(pixelArray: list, wordBytes: int) -> tuple[list, list]:
+		"""
+		Compress image data with extended RLE
+
+		Works like the basic RLE, but runs and literal blocks of more than 127 words are
+		stored in a single instruction: A zero byte followed by the instruction as signed
+		16 bit value, limited to RLE_EXT_MAX words. Large areas of a single color take a
+		few bytes and the decoder fills them at once.
+
+		Arguments
+		---------
+		pixelArray : list
+			Words of the image data to compress
+		wordBytes : int
+			Bytes per word, short runs of single byte words are cheaper as part of a literal block
+
+		Returns : (list, list)
+			Positions of the RLE instructions within the compressed data (ending with None)
+			and the compressed data, holding the instructions and the words
+		"""
+		outlist = []
+		rlePos = []
+		minRun = 2 if (wordBytes > 1) else 3
+		data = np.asarray(pixelArray, dtype=np.int64)
+
+		def addLiteral(start: int, end: int):
+			while (start < end):
+				count = min(end - start, PIF.RLE_EXT_MAX)
+				rlePos.append(len(outlist))
+				outlist.append(-count)
+				outlist.extend(pixelArray[start : start + count])
+				start += count
+
+		# Start and length of every sequence of equal words
+		runStarts = np.flatnonzero(np.concatenate(([True], data[1:] != data[:-1]))) if (data.size > 0) else np.array([], dtype=np.int64)
+		runLengths = np.diff(np.append(runStarts, data.size))
+
+		# Short sequences stay within the literal block around them
+		literalStart = 0
+		for runStart, runLength in zip(runStarts.tolist(), runLengths.tolist()):
+			if (runLength < minRun):
+				continue
+			addLiteral(literalStart, runStart)
+			literalStart = runStart + runLength
+			while (runLength > 0):
+				count = min(runLength, PIF.RLE_EXT_MAX)
+				rlePos.append(len(outlist))
+				outlist.append(count)
+				outlist.append(pixelArray[runStart])
+				runLength -= count
+		addLiteral(literalStart, data.size)
+
+		rlePos.append(None)
+		return rlePos, outlist
+
 	def __LEGACYconvertToPIF(image: PIL.Image.Image, conversion: PIFType, colorLength: int, colorTable: np.ndarray, dithering: bool, compression: CompressionType):
 		"""
 		Convert image to various PIF arrays
@@ -653,6 +743,8 @@ class PIF():
 		# compress the data if requested
 		if (compression == PIF.CompressionType.RLE_COMPRESSION):
 			rlePos, imageData = PIF.__LEGACYrleCompress(imageData)
+		elif (compression == PIF.CompressionType.RLE_EXT_COMPRESSION):
+			rlePos, imageData = PIF.__rleCompressExtended(imageData, max(imageHeader[ImageH.BITSPERPIXEL.value] // 8, 1))
 		else:
 			rlePos = [None]
 
@@ -695,6 +787,8 @@ class PIF():
 		tImgHeader[15] = (imageHeader[6] & 0xFF00) >> 8
 
 		if (imageHeader[5] > 0):
+			# Plain integers, numpy 2 refuses masks beyond the range of the uint8 table entries
+			colorTable = [int(color) for color in colorTable]
 			for index in range(len(colorTable)):
 				if (imageHeader[0] == 0x4942):
 					tColTable[index] = colorTable[index]
@@ -712,7 +806,11 @@ class PIF():
 			# RLE Data is always only 1 byte large, while image data can be up to three bytes large
 			if ((imageHeader[6] != 0) and (rlePos[rleIndex] == index)):
 				rleIndex += 1
-				tImgData.append(imageData[index] & 0xFF)
+				if (-128 < imageData[index] < 128):
+					tImgData.append(imageData[index] & 0xFF)
+				else:
+					# Extended RLE instruction: Zero byte, followed by the instruction as int16
+					tImgData.extend([0, imageData[index] & 0xFF, (imageData[index] >> 8) & 0xFF])
 			else:
 				if (imageHeader[1] == 16):
 					tImgData.append(imageData[index] & 0xFF)
@@ -904,7 +1002,87 @@ class PIF():
 		
 		return (imageToReturn, (IndexedColorTable, ColorTableLength))
 
-	def encodeFile(image: PIL.Image.Image, imageType: PIFType, compression: CompressionType, IndexedColorTable: None | tuple[np.ndarray, int], dithering: bool = False) -> np.ndarray:
+	def __buildRowIndex(imageData: np.ndarray, bitsPerPixel: int, imageWidth: int, imageHeight: int, everyNRows: int, extended: bool = False) -> list[tuple[int, int]]:
+		"""
+		Build the row index of RLE image data
+
+		For every everyNRows-th row, the offset of the RLE instruction holding the first
+		pixel of the row (relative to the start of the image data) and the amount of pixels
+		of that instruction belonging to the rows above are stored.
+
+		Returns : list[tuple[int, int]]
+			List of (offset, pixels) tuples, one per indexed row
+		"""
+		wordBytes = 1 if bitsPerPixel < 8 else bitsPerPixel // 8
+		# 3 bit pixels are stored like 4 bit pixels
+		wordPixels = 8 if bitsPerPixel == 1 else 4 if bitsPerPixel == 2 else 2 if bitsPerPixel <= 4 else 1
+		entries = (imageHeight + everyNRows - 1) // everyNRows
+		rowIndex = []
+		rowPixel = 0
+		pixelPos = 0
+		instrPos = 0
+
+		while (instrPos < len(imageData)) and (len(rowIndex) < entries):
+			rleInstruction = int(imageData[instrPos])
+			if (rleInstruction > 127):	rleInstruction -= 256
+			instrBytes = 1
+			if (extended and rleInstruction == 0):
+				rleInstruction = int(imageData[instrPos + 1]) + (int(imageData[instrPos + 2]) << 8)
+				if (rleInstruction > 32767):	rleInstruction -= 65536
+				if (rleInstruction == 0 or abs(rleInstruction) > PIF.RLE_EXT_MAX):
+					raise ValueError(f'Invalid extended RLE instruction {rleInstruction} at offset {instrPos}')
+				instrBytes = 3
+			runPixels = abs(rleInstruction) * wordPixels
+
+			while (rowPixel < pixelPos + runPixels) and (len(rowIndex) < entries):
+				rowIndex.append((instrPos, rowPixel - pixelPos))
+				rowPixel += everyNRows * imageWidth
+			
+			pixelPos += runPixels
+			if (rleInstruction < 0):
+				instrPos += instrBytes - rleInstruction * wordBytes
+			elif (rleInstruction > 0):
+				instrPos += instrBytes + wordBytes
+			else:
+				instrPos += instrBytes
+
+		# Rows without any data point to the end of the image data
+		while (len(rowIndex) < entries):
+			rowIndex.append((len(imageData), 0))
+
+		return rowIndex
+
+	def __addRowIndex(dataPIF: np.ndarray, everyNRows: int) -> np.ndarray:
+		"""
+		Insert a row index between the color table and the image data
+
+		The image offset and file size within the header are updated, so decoders
+		without row index support simply skip it.
+
+		Returns : numpy.ndarray
+			PIF data with the row index
+		"""
+		imageOffset = int(dataPIF[8]) + (int(dataPIF[9]) << 8) + (int(dataPIF[10]) << 16) + (int(dataPIF[11]) << 24)
+		bitsPerPixel = int(dataPIF[14]) + (int(dataPIF[15]) << 8)
+		imageWidth = int(dataPIF[16]) + (int(dataPIF[17]) << 8)
+		imageHeight = int(dataPIF[18]) + (int(dataPIF[19]) << 8)
+		extended = (int(dataPIF[26]) + (int(dataPIF[27]) << 8)) == PIF.CompressionType.RLE_EXT_COMPRESSION.value
+
+		rowIndex = PIF.__buildRowIndex(dataPIF[imageOffset:], bitsPerPixel, imageWidth, imageHeight, everyNRows, extended)
+
+		indexBlock = list(PIF.ROWINDEX_MAGIC)
+		indexBlock.extend([everyNRows & 0xFF, everyNRows >> 8, len(rowIndex) & 0xFF, len(rowIndex) >> 8])
+		for offset, pixels in rowIndex:
+			indexBlock.extend([offset & 0xFF, (offset >> 8) & 0xFF, (offset >> 16) & 0xFF, (offset >> 24) & 0xFF, pixels & 0xFF, pixels >> 8])
+
+		dataPIF = np.concatenate((dataPIF[:imageOffset], np.array(indexBlock, dtype=np.uint8), dataPIF[imageOffset:]))
+		imageOffset += len(indexBlock)
+		dataPIF[4:8] = np.frombuffer(dataPIF.size.to_bytes(4, 'little'), dtype=np.uint8)
+		dataPIF[8:12] = np.frombuffer(imageOffset.to_bytes(4, 'little'), dtype=np.uint8)
+
+		return dataPIF
+
+	def encodeFile(image: PIL.Image.Image, imageType: PIFType, compression: CompressionType, IndexedColorTable: None | tuple[np.ndarray, int], dithering: bool = False, rowIndexRows: int = 0) -> np.ndarray:
 		""" Converts the image to the PIF format
 
 		Converts an pillow image to an image in the PIF format and PIFType.
@@ -920,6 +1098,9 @@ class PIF():
 				Otherwise a tuple containing a [R,G,B] numpy array and the amount of colors
 			dithering : bool
 				Enable dithering, doesn't work for ImageTypeRGB888 or ImageTypeRGB565
+			rowIndexRows : int
+				Store a row index every rowIndexRows rows, so RLE images can be decoded
+				starting at any row band. Only used with either RLE compression, 0 disables it
 		
 		Returns : numpy.ndarray
 			PIF data within an numpy array, which can be saved using .tofile(path)
@@ -933,6 +1114,8 @@ class PIF():
 		
 		imageHeader, colorTable, imageData, rlePos = PIF.__LEGACYconvertToPIF(image, imageType, ColorIndexLength, ColorIndexTable, dithering, compression)
 		dataPIF,_ = PIF.__LEGACYsavePIFbinary(imageHeader, colorTable, imageData, rlePos)		
+		if (rowIndexRows > 0) and (compression != PIF.CompressionType.NO_COMPRESSION):
+			dataPIF = PIF.__addRowIndex(dataPIF, rowIndexRows)
 		return dataPIF
 	
 	def encodePreview(image: PIL.Image.Image, imageType: PIFType, IndexedColorTable: None | tuple[np.ndarray, int], dithering: bool = False) -> PIL.Image.Image:
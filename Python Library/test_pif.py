@@ -7,11 +7,15 @@ import sys
 sys.path.append('Python_Library/')
 from pif import *
 
+# Optional third entry: store a row index (RIDX block) every n rows
 TEST_LIST = [
 	(PIF.PIFType.ImageTypeRGB888, PIF.CompressionType.NO_COMPRESSION),
 	(PIF.PIFType.ImageTypeRGB888, PIF.CompressionType.RLE_COMPRESSION),
 	(PIF.PIFType.ImageTypeRGB565, PIF.CompressionType.NO_COMPRESSION),
 	(PIF.PIFType.ImageTypeRGB565, PIF.CompressionType.RLE_COMPRESSION),
+	(PIF.PIFType.ImageTypeRGB565, PIF.CompressionType.RLE_EXT_COMPRESSION),
+	(PIF.PIFType.ImageTypeRGB565, PIF.CompressionType.RLE_COMPRESSION, 16),
+	(PIF.PIFType.ImageTypeRGB565, PIF.CompressionType.RLE_EXT_COMPRESSION, 16),
 	(PIF.PIFType.ImageTypeRGB332, PIF.CompressionType.NO_COMPRESSION),
 	(PIF.PIFType.ImageTypeRGB332, PIF.CompressionType.RLE_COMPRESSION),
 	(PIF.PIFType.ImageTypeRGB332, PIF.CompressionType.NO_COMPRESSION),
@@ -19,12 +23,14 @@ TEST_LIST = [
 	(PIF.PIFType.ImageTypeRGB16C, PIF.CompressionType.RLE_COMPRESSION),
 	(PIF.PIFType.ImageTypeBLWH,	  PIF.CompressionType.NO_COMPRESSION),
 	(PIF.PIFType.ImageTypeBLWH,	  PIF.CompressionType.RLE_COMPRESSION),
+	(PIF.PIFType.ImageTypeBLWH,	  PIF.CompressionType.RLE_EXT_COMPRESSION),
 	(PIF.PIFType.ImageTypeIND24,  PIF.CompressionType.NO_COMPRESSION),
 	(PIF.PIFType.ImageTypeIND24,  PIF.CompressionType.RLE_COMPRESSION),
 	(PIF.PIFType.ImageTypeIND16,  PIF.CompressionType.NO_COMPRESSION),
 	(PIF.PIFType.ImageTypeIND16,  PIF.CompressionType.RLE_COMPRESSION),
 	(PIF.PIFType.ImageTypeIND8,	  PIF.CompressionType.NO_COMPRESSION),
 	(PIF.PIFType.ImageTypeIND8,	  PIF.CompressionType.RLE_COMPRESSION),
+	(PIF.PIFType.ImageTypeIND8,	  PIF.CompressionType.RLE_COMPRESSION, 7),
 ]
 
 test_colorTable = (np.array([[255, 255, 255],
@@ -43,6 +49,40 @@ The PIF and BMP files are saved in a test folder, which have to be
 then manually inspected.
 """
 
+def checkRowIndex(rawPIF, imageInfo, rowIndexRows):
+    """
+    Walks the RLE instructions of the image data and checks that every entry
+    of the parsed row index points to the instruction holding the first pixel
+    of its row, with the right amount of pixels belonging to the rows above.
+    """
+    width = imageInfo.imageWidth
+    entries = (imageInfo.imageHeigt + rowIndexRows - 1) // rowIndexRows
+    if (imageInfo.rowIndexRows != rowIndexRows) or (imageInfo.rowIndex is None) or (len(imageInfo.rowIndex) != entries):
+        raise ValueError(f'Row index not read back, {imageInfo.rowIndexRows} rows / {None if imageInfo.rowIndex is None else len(imageInfo.rowIndex)} entries')
+    bpp = imageInfo.bitsPerPixel
+    wordBytes = 1 if bpp < 8 else bpp // 8
+    wordPixels = 8 if bpp == 1 else 4 if bpp == 2 else 2 if bpp <= 4 else 1
+    extended = imageInfo.compression == PIF.CompressionType.RLE_EXT_COMPRESSION
+    data = rawPIF[imageInfo.imageOffset : imageInfo.imageOffset + imageInfo.imageSize]
+    # Pixels decoded before each instruction, keyed by its offset
+    pixelsBefore = {}
+    pos = 0
+    pixels = 0
+    while pos < len(data):
+        pixelsBefore[pos] = pixels
+        count = int(data[pos])
+        if count > 127:  count -= 256
+        instrBytes = 1
+        if extended and count == 0:
+            count = int(data[pos + 1]) + (int(data[pos + 2]) << 8)
+            if count > 32767:  count -= 65536
+            instrBytes = 3
+        pixels += abs(count) * wordPixels
+        pos += instrBytes + (wordBytes if count > 0 else -count * wordBytes)
+    for entry, (offset, skip) in enumerate(imageInfo.rowIndex):
+        if (offset not in pixelsBefore) or (pixelsBefore[offset] + skip != entry * rowIndexRows * width):
+            raise ValueError(f'Row index entry {entry} ({offset}, {skip}) does not point to row {entry * rowIndexRows}')
+
 testpath = 'Python Library/testing'
 if not os.path.exists(testpath):
     os.makedirs(testpath)
@@ -50,17 +90,44 @@ if not os.path.exists(testpath):
 origImage = PIL.Image.open(imagePath)
 
 for test_case in TEST_LIST:
-    print(f'\n\nTesting {test_case[0].name} with {test_case[1].name}')
+    rowIndexRows = test_case[2] if len(test_case) > 2 else 0
+    print(f'\n\nTesting {test_case[0].name} with {test_case[1].name}' + (f' and a row index every {rowIndexRows} rows' if rowIndexRows else ''))
     print(f'Opening and encoding file...')
     startTime = time.time()
-    rawPIF = PIF.encodeFile(origImage, test_case[0], test_case[1], test_colorTable, True if test_case[1] == PIF.CompressionType.NO_COMPRESSION else False)
+    rawPIF = PIF.encodeFile(origImage, test_case[0], test_case[1], test_colorTable, True if test_case[1] == PIF.CompressionType.NO_COMPRESSION else False, rowIndexRows)
     endTime = time.time()
     print(f' {endTime - startTime} seconds\n')
     print(f'Decoding file...')
     startTime = time.time()
-    decodedPIF, _ = PIF.decode(rawPIF)
+    decodedPIF, imageInfo = PIF.decode(rawPIF)
     endTime = time.time()
     print(f' {endTime - startTime} seconds\n')
+    if rowIndexRows:
+        print(f'Checking the row index...')
+        checkRowIndex(rawPIF, imageInfo, rowIndexRows)
+        # The index must not change the image data itself
+        plainPIF, plainInfo = PIF.decode(PIF.encodeFile(origImage, test_case[0], test_case[1], test_colorTable, False))
+        if (not np.array_equal(imageInfo.rawImageData, plainInfo.rawImageData)) or (not np.array_equal(np.asarray(decodedPIF), np.asarray(plainPIF))):
+            print(' Image with row index differs from the image without')
+            sys.exit(1)
+        print(f' {len(imageInfo.rowIndex)} entries OK\n')
     print(f'End')
-    decodedPIF.save(f'{testpath}/{(test_case[0].name).split(".")[-1]}{"_rle" if test_case[1] == PIF.CompressionType.RLE_COMPRESSION  else ""}.bmp')
-    rawPIF.tofile(f'{testpath}/{(test_case[0].name).split(".")[-1]}{"_rle" if test_case[1] == PIF.CompressionType.RLE_COMPRESSION  else ""}.pif')
+    suffix = {PIF.CompressionType.RLE_COMPRESSION: '_rle', PIF.CompressionType.RLE_EXT_COMPRESSION: '_rleext'}.get(test_case[1], '')
+    suffix += '_ridx' if rowIndexRows else ''
+    decodedPIF.save(f'{testpath}/{(test_case[0].name).split(".")[-1]}{suffix}.bmp')
+    rawPIF.tofile(f'{testpath}/{(test_case[0].name).split(".")[-1]}{suffix}.pif')
+
+"""
+Extended RLE counts beyond RLE_EXT_MAX are no valid image data,
+decoding has to fail instead of drawing garbage.
+"""
+print(f'\n\nTesting an extended RLE count beyond {PIF.RLE_EXT_MAX} words')
+rawPIF = PIF.encodeFile(origImage, PIF.PIFType.ImageTypeRGB565, PIF.CompressionType.RLE_EXT_COMPRESSION, test_colorTable, False)
+imageOffset = int(rawPIF[8]) + (int(rawPIF[9]) << 8) + (int(rawPIF[10]) << 16) + (int(rawPIF[11]) << 24)
+rawPIF[imageOffset:imageOffset + 3] = [0, (PIF.RLE_EXT_MAX + 1) & 0xFF, (PIF.RLE_EXT_MAX + 1) >> 8]
+try:
+    PIF.decode(rawPIF)
+    print('Malformed image decoded without error')
+    sys.exit(1)
+except ValueError as error:
+    print(f' Rejected: {error}')